@@ -0,0 +1,58 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rngs.h"
+
+/* Time of one cardEffect call per action card.  Each play starts from
+   the same position: the card at hand position 0, a Copper at 1, and
+   the journal rolls the state back afterwards, so the time includes the
+   undo of everything the card wrote */
+
+#define PLAYS 200000
+
+int main () {
+
+  int kingdoms[2][10] = {{adventurer, council_room, feast, gardens, mine,
+			  remodel, smithy, village, baron, great_hall},
+			 {minion, steward, tribute, ambassador, cutpurse,
+			  embargo, outpost, salvager, sea_hag, treasure_map}};
+  int set, i, n, card, mark, bonus;
+  clock_t start;
+  struct gameState G;
+  struct moveJournal *journal = newJournal();
+
+  if (journal == NULL)
+    return 1;
+  printf ("%-14s %10s\n", "card", "ns/play");
+  for (set = 0; set < 2; set++)
+    {
+      initializeGame(2, kingdoms[set], 1, &G);
+      G.journal = journal;
+      for (i = 0; i < 10; i++)
+	{
+	  card = kingdoms[set][i];
+	  if (!(cardTable[card].types & ACTION_CARD))
+	    continue;
+	  clearJournal(journal);
+	  setPileCard(0, card, hand_pile, 0, &G);
+	  setPileCard(1, copper, hand_pile, 0, &G);
+	  mark = markJournal(&G);
+	  start = clock();
+	  for (n = 0; n < PLAYS; n++)
+	    {
+	      //feast gains the card named by choice1, the others a Silver;
+	      //ambassador returns no copies
+	      cardEffect(card, card == feast ? silver : 1,
+			 card == ambassador ? 0 : silver, 0, &G, 0, &bonus);
+	      undoJournal(mark, &G);
+	    }
+	  printf ("%-14s %10.1f\n", cardTable[card].name,
+		  (double)(clock() - start) / CLOCKS_PER_SEC / PLAYS * 1e9);
+	}
+      G.journal = NULL;
+    }
+  freeJournal(journal);
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "rngs.h"
+
+/* Times playCard/buyCard/endTurn over many live games at once, so each
+   call lands on a state that is not in cache, then a scan that reads only
+   the per-turn fields and supply of every game, as a scheduler or
+   evaluator would.  Build with and without -DSPLIT_LAYOUT (make bench)
+   to compare the two struct layouts. */
+
+#define GAMES 4096
+#define ROUNDS 25
+#define SCANS 2500
+
+//bytes from the first to the end of the last of the per-turn fields
+unsigned long hotSpan() {
+  size_t offsets[7] = {offsetof(struct gameState, whoseTurn),
+		       offsetof(struct gameState, phase),
+		       offsetof(struct gameState, numActions),
+		       offsetof(struct gameState, coins),
+		       offsetof(struct gameState, numBuys),
+		       offsetof(struct gameState, outpostPlayed),
+		       offsetof(struct gameState, playedCardCount)};
+  size_t low = offsets[0], high = offsets[0];
+  int i;
+
+  for (i = 1; i < 7; i++)
+    {
+      if (offsets[i] < low) low = offsets[i];
+      if (offsets[i] > high) high = offsets[i];
+    }
+  return (unsigned long)(high + sizeof(int) - low);
+}
+
+int main () {
+
+  int i, g, round, ops = 0;
+  long sum = 0;
+  clock_t start;
+  double seconds;
+  struct gameState *G;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+
+#ifdef SPLIT_LAYOUT
+  printf ("Layout: split hot/cold\n");
+#else
+  printf ("Layout: original\n");
+#endif
+  printf ("sizeof(struct gameState) = %lu, hot fields span %lu bytes, supply starts at %lu\n",
+	  (unsigned long)sizeof(struct gameState), hotSpan(),
+	  (unsigned long)offsetof(struct gameState, supplyCount));
+
+  G = malloc(sizeof(struct gameState) * GAMES);
+  if (G == NULL)
+    {
+      return 1;
+    }
+  for (g = 0; g < GAMES; g++)
+    {
+      initializeGame(2 + g % 3, k, g + 1, &G[g]);
+    }
+
+  SelectStream(2);
+  PutSeed(1);
+
+  start = clock();
+  for (round = 0; round < ROUNDS; round++)
+    {
+      for (g = 0; g < GAMES; g++)
+	{
+	  if (isGameOver(&G[g]))
+	    {
+	      initializeGame(2 + g % 3, k, g + round + 1, &G[g]);
+	      SelectStream(2);
+	    }
+	  //play what can be played, buy, clean up
+	  for (i = 0; i < numHandCards(&G[g]) && G[g].numActions > 0; i++)
+	    {
+	      if (handCard(i, &G[g]) >= adventurer)
+		{
+		  playCard(i, 1, silver, 0, &G[g]);
+		  ops++;
+		}
+	    }
+	  buyCard(G[g].coins >= 8 ? province : G[g].coins >= 6 ? gold
+		  : G[g].coins >= 3 ? silver : copper, &G[g]);
+	  buyCard(floor(Random() * (treasure_map + 1)), &G[g]);
+	  endTurn(&G[g]);
+	  ops += 3;
+	}
+    }
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  printf ("moves: %d calls in %.3f s, %.1f ns per call\n", ops, seconds,
+	  1e9 * seconds / ops);
+
+  start = clock();
+  for (round = 0; round < SCANS; round++)
+    {
+      for (g = 0; g < GAMES; g++)
+	{
+	  sum += G[g].whoseTurn + G[g].phase + G[g].numActions + G[g].coins
+	    + G[g].numBuys + G[g].outpostPlayed + G[g].playedCardCount
+	    + G[g].supplyCount[province] + G[g].supplyCount[round % (treasure_map+1)];
+	}
+    }
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  printf ("scan: %d states in %.3f s, %.1f ns per state (checksum %ld)\n",
+	  SCANS * GAMES, seconds, 1e9 * seconds / ((double)SCANS * GAMES), sum);
+
+  free(G);
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rngs.h"
+
+/* Draws per second from each generator through the scalar, bulk and
+   integer calls, then games per second with every game shuffling from a
+   context running that generator.  make bench builds it as a simulation
+   build, where shuffles draw with RandomInt */
+
+#define DRAWS 20000000
+#define FILL 4096
+#define GAMES 20000
+#define MAX_TURNS 100
+
+//big money with smithy, no random choices of its own
+void playGame(int seed, RngState *rng, struct gameState *state) {
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+  int i, turn;
+
+  initializeGameWithRng(2, k, seed, rng, state);
+  for (turn = 0; turn < MAX_TURNS && !isGameOver(state); turn++)
+    {
+      for (i = 0; i < numHandCards(state) && state->numActions > 0; i++)
+	{
+	  if (handCard(i, state) == smithy)
+	    playCard(i, 0, 0, 0, state);
+	}
+      buyCard(state->coins >= 8 ? province : state->coins >= 6 ? gold
+	      : state->coins == 4 ? smithy : silver, state);
+      endTurn(state);
+    }
+}
+
+double since(clock_t start) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main () {
+
+  const char *names[2] = {"lehmer", "xoshiro256**"};
+  int generator, i, j;
+  long sum = 0;
+  double total = 0;
+  double fill[FILL];
+  clock_t start;
+  RngState rng;
+  struct gameState G;
+
+  printf ("%-13s %14s %14s %14s %12s\n", "generator", "Random M/s",
+	  "RandomFill M/s", "RandomInt M/s", "games/s");
+  for (generator = RNG_LEHMER; generator <= RNG_XOSHIRO256; generator++)
+    {
+      printf ("%-13s", names[generator]);
+      SelectGeneratorCtx(&rng, generator);
+      PutSeedCtx(&rng, 1);
+
+      start = clock();
+      for (i = 0; i < DRAWS; i++)
+	total += RandomCtx(&rng);
+      printf (" %14.1f", DRAWS / since(start) / 1e6);
+
+      start = clock();
+      for (i = 0; i < DRAWS; i += FILL)
+	{
+	  RandomFill(&rng, fill, FILL);
+	  total += fill[i % FILL];
+	}
+      printf (" %14.1f", DRAWS / since(start) / 1e6);
+
+      start = clock();
+      for (i = 0; i < DRAWS; i++)
+	sum += RandomInt(&rng, 1 + (i & 63));
+      printf (" %14.1f", DRAWS / since(start) / 1e6);
+
+      start = clock();
+      for (j = 0; j < GAMES; j++)
+	{
+	  playGame(j + 1, &rng, &G);
+	  sum += G.whoseTurn;
+	}
+      printf (" %12.0f\n", GAMES / since(start));
+    }
+  printf ("(checksum %.1f %ld)\n", total, sum);
+
+  return 0;
+}
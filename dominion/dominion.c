@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 
 int compare(const void* a, const void* b) {
   if (*(int*)a > *(int*)b)
@@ -13,14 +15,393 @@ int compare(const void* a, const void* b) {
   return 0;
 }
 
+//PILE_BIT for any arguments, 0 for a player outside the game arrays
+static unsigned int pileBit(int pile, int player) {
+  if (pile != played_pile && (player < 0 || player >= MAX_PLAYERS))
+    return 0;
+  return PILE_BIT(pile, player);
+}
+
+struct journalEntry {
+  void* field;
+  int value; //value before the write
+  int width; //sizeof the field, an int or a supply_t
+};
+
+struct journalMark {
+  int entries; //journal length when the mark was taken
+  RngPosition rng;
+  unsigned long long hash; //not journaled, it is a function of the state
+};
+
+struct moveJournal {
+  struct journalEntry* entries;
+  int count;
+  int capacity;
+  struct journalMark* marks;
+  int markCount;
+  int markCapacity;
+  int lostMarks; //marks below this were taken before a write went unrecorded
+};
+
+//double an array of size items of the given width, -1 if out of memory
+static int growArray(void **items, int *capacity, size_t width) {
+  int newCapacity = (*capacity < 16) ? 16 : 2 * *capacity;
+  void* grown = realloc(*items, newCapacity * width);
+
+  if (grown == NULL)
+    {
+      return -1;
+    }
+  *items = grown;
+  *capacity = newCapacity;
+  return 0;
+}
+
+//note the prior value of a field about to be written, if journaling
+static void record(void *field, int value, int width, struct gameState *state) {
+  struct moveJournal* journal = state->journal;
+
+  if (journal == NULL)
+    {
+      return;
+    }
+  if (journal->count == journal->capacity
+      && growArray((void**)&journal->entries, &journal->capacity,
+		   sizeof(struct journalEntry)) < 0)
+    {
+      journal->lostMarks = journal->markCount;
+      return;
+    }
+  journal->entries[journal->count].field = field;
+  journal->entries[journal->count].value = value;
+  journal->entries[journal->count].width = width;
+  journal->count++;
+}
+
+//write one int of the state, recording its prior value in the journal
+static void store(int *field, int value, struct gameState *state) {
+  record(field, *field, sizeof(int), state);
+  *field = value;
+}
+
+//same for the supply and embargo counts, which are narrower in SPLIT_LAYOUT
+static void storeSupply(supply_t *field, int value, struct gameState *state) {
+  record(field, *field, sizeof(supply_t), state);
+  *field = value;
+}
+
+//coins from an action, on top of the treasure in hand
+static void addBonusCoins(int coins, struct gameState *state) {
+  store(&state->bonusCoins, state->bonusCoins + coins, state);
+  store(&state->coins, state->coins + coins, state);
+}
+
+//hash positions: supply, embargo, then every slot of every pile
+#define HASH_SUPPLY 0
+#define HASH_EMBARGO (treasure_map+1)
+#define HASH_PILES (2 * (treasure_map+1))
+#define HASH_ZONES (HASH_PILES + PILE_SLOTS * MAX_DECK)            /* canonicalKey only */
+#define HASH_KNOWN (HASH_ZONES + PILE_SLOTS * (treasure_map+1))    /* canonicalKey only */
+
+//64-bit key for a value held at a hash position (splitmix64 finalizer)
+static unsigned long long hashKey(int where, int value) {
+  unsigned long long z = ((unsigned long long)(unsigned int)where << 32)
+    | (unsigned int)value;
+
+  z += 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+//key for a live card at position pos of a pile
+static unsigned long long cardKey(int card, int pos, int pile, int player) {
+  int slot = (pile == played_pile) ? MAX_PLAYERS * PLAYER_PILES : player * PLAYER_PILES + pile;
+
+  return hashKey(HASH_PILES + slot * MAX_DECK + pos, card);
+}
+
+#define DEFAULT_POOL_BLOCK 16
+
+//free slots are linked through their own storage
+struct poolSlot {
+  struct poolSlot* next;
+};
+
+//blockSize slots of one size, game states or kingdom arrays
+struct poolBlock {
+  struct poolBlock* next;
+  char* slots;
+};
+
+struct gamePool {
+  int blockSize;
+  struct poolBlock* stateBlocks;
+  struct poolBlock* kingdomBlocks;
+  struct poolSlot* freeStates;
+  struct poolSlot* freeKingdoms;
+  int hasTemplate;
+  RngPosition templateRng; //stream 1 right after the template was initialized
+  int templateGenerator; //of the global streams at that time
+  struct gameState template;
+};
+
+static struct gamePool* defaultPool = NULL;
+
+static struct gamePool* poolOrDefault(struct gamePool *pool) {
+  if (pool == NULL)
+    {
+      if (defaultPool == NULL)
+	{
+	  defaultPool = newGamePool(DEFAULT_POOL_BLOCK);
+	}
+      pool = defaultPool;
+    }
+  return pool;
+}
+
+//allocate another block of slotSize slots and put them all on freeList;
+//states and kingdom arrays grow separately, each when its own list runs dry
+static int growPool(struct gamePool *pool, struct poolBlock **blocks,
+		    struct poolSlot **freeList, size_t slotSize) {
+  int i;
+  struct poolSlot* slot;
+  struct poolBlock* block = malloc(sizeof(struct poolBlock));
+
+  if (block == NULL)
+    {
+      return -1;
+    }
+  block->slots = calloc(pool->blockSize, slotSize);
+  if (block->slots == NULL)
+    {
+      free(block);
+      return -1;
+    }
+
+  for (i = 0; i < pool->blockSize; i++)
+    {
+      slot = (struct poolSlot*)(block->slots + i * slotSize);
+      slot->next = *freeList;
+      *freeList = slot;
+    }
+  block->next = *blocks;
+  *blocks = block;
+
+  return 0;
+}
+
+//whether p is the start of a slot in one of blocks
+static int ownsSlot(struct gamePool *pool, struct poolBlock *blocks,
+		    void *p, size_t slotSize) {
+  struct poolBlock* block;
+  char* c = p;
+
+  for (block = blocks; block != NULL; block = block->next)
+    {
+      if (c >= block->slots && c < block->slots + pool->blockSize * slotSize)
+	{
+	  return (size_t)(c - block->slots) % slotSize == 0;
+	}
+    }
+  return 0;
+}
+
+static void freeBlocks(struct poolBlock *blocks) {
+  struct poolBlock* block;
+
+  while (blocks != NULL)
+    {
+      block = blocks;
+      blocks = block->next;
+      free(block->slots);
+      free(block);
+    }
+}
+
+struct gamePool* newGamePool(int blockSize) {
+  struct gamePool* pool;
+
+  if (blockSize < 1)
+    {
+      return NULL;
+    }
+  pool = malloc(sizeof(struct gamePool));
+  if (pool == NULL)
+    {
+      return NULL;
+    }
+  pool->blockSize = blockSize;
+  pool->stateBlocks = NULL;
+  pool->kingdomBlocks = NULL;
+  pool->freeStates = NULL;
+  pool->freeKingdoms = NULL;
+  pool->hasTemplate = 0;
+  return pool;
+}
+
+int freeGamePool(struct gamePool *pool) {
+  pool = poolOrDefault(pool);
+  if (pool == NULL)
+    {
+      return -1;
+    }
+  freeBlocks(pool->stateBlocks);
+  freeBlocks(pool->kingdomBlocks);
+  if (pool == defaultPool)
+    {
+      defaultPool = NULL;
+    }
+  free(pool);
+  return 0;
+}
+
+struct gameState* acquireGame(struct gamePool *pool) {
+  struct poolSlot* slot;
+
+  pool = poolOrDefault(pool);
+  if (pool == NULL || (pool->freeStates == NULL
+			&& growPool(pool, &pool->stateBlocks, &pool->freeStates,
+				    sizeof(struct gameState)) < 0))
+    {
+      return NULL;
+    }
+  slot = pool->freeStates;
+  pool->freeStates = slot->next;
+  memset(slot, 0, sizeof(struct gameState));
+  return (struct gameState*)slot;
+}
+
+int releaseGame(struct gamePool *pool, struct gameState *state) {
+  struct poolSlot* slot = (struct poolSlot*)state;
+
+  pool = poolOrDefault(pool);
+  if (pool == NULL || state == NULL)
+    {
+      return -1;
+    }
+  //walking the blocks costs a pass over the pool, so only in DEBUG builds
+  if (DEBUG && !ownsSlot(pool, pool->stateBlocks, state, sizeof(struct gameState)))
+    {
+      printf("releaseGame: state %p was not acquired from this pool\n", (void*)state);
+      return -1;
+    }
+  slot->next = pool->freeStates;
+  pool->freeStates = slot;
+  return 0;
+}
+
+int* acquireKingdomCards(struct gamePool *pool) {
+  struct poolSlot* slot;
+
+  pool = poolOrDefault(pool);
+  if (pool == NULL || (pool->freeKingdoms == NULL
+			&& growPool(pool, &pool->kingdomBlocks, &pool->freeKingdoms,
+				    sizeof(int[10])) < 0))
+    {
+      return NULL;
+    }
+  slot = pool->freeKingdoms;
+  pool->freeKingdoms = slot->next;
+  return (int*)slot;
+}
+
+int releaseKingdomCards(struct gamePool *pool, int *k) {
+  struct poolSlot* slot = (struct poolSlot*)k;
+
+  pool = poolOrDefault(pool);
+  if (pool == NULL || k == NULL)
+    {
+      return -1;
+    }
+  if (DEBUG && !ownsSlot(pool, pool->kingdomBlocks, k, sizeof(int[10])))
+    {
+      printf("releaseKingdomCards: array %p was not acquired from this pool\n", (void*)k);
+      return -1;
+    }
+  slot->next = pool->freeKingdoms;
+  pool->freeKingdoms = slot;
+  return 0;
+}
+
+int setPoolTemplate(struct gamePool *pool, int numPlayers, int kingdomCards[10],
+		    int randomSeed) {
+  pool = poolOrDefault(pool);
+  if (pool == NULL)
+    {
+      return -1;
+    }
+  memset(&pool->template, 0, sizeof(struct gameState));
+  if (initializeGame(numPlayers, kingdomCards, randomSeed, &pool->template) < 0)
+    {
+      pool->hasTemplate = 0;
+      return -1;
+    }
+  //initializeGame draws from stream 1
+  GetPositionCtx(NULL, &pool->templateRng);
+  pool->templateGenerator = GetGeneratorCtx(NULL);
+  pool->hasTemplate = 1;
+  return 0;
+}
+
+//copy everything but the dead slots past the end of each pile
+static void copyLiveState(struct gameState *dst, struct gameState *src) {
+  int i;
+  int n = src->numPlayers;
+
+  dst->numPlayers = src->numPlayers;
+  memcpy(dst->supplyCount, src->supplyCount, sizeof(src->supplyCount));
+  memcpy(dst->embargoTokens, src->embargoTokens, sizeof(src->embargoTokens));
+  dst->outpostPlayed = src->outpostPlayed;
+  dst->outpostTurn = src->outpostTurn;
+  dst->whoseTurn = src->whoseTurn;
+  dst->phase = src->phase;
+  dst->numActions = src->numActions;
+  dst->coins = src->coins;
+  dst->numBuys = src->numBuys;
+  memcpy(dst->handCount, src->handCount, sizeof(src->handCount));
+  memcpy(dst->deckCount, src->deckCount, sizeof(src->deckCount));
+  memcpy(dst->discardCount, src->discardCount, sizeof(src->discardCount));
+  dst->playedCardCount = src->playedCardCount;
+  for (i = 0; i < n; i++)
+    {
+      memcpy(dst->hand[i], src->hand[i], sizeof(int) * src->handCount[i]);
+      memcpy(dst->deck[i], src->deck[i], sizeof(int) * src->deckCount[i]);
+      memcpy(dst->discard[i], src->discard[i], sizeof(int) * src->discardCount[i]);
+    }
+  memcpy(dst->playedCards, src->playedCards, sizeof(int) * src->playedCardCount);
+
+  //cached fields live together at the end of the struct
+  memcpy((char*)dst + offsetof(struct gameState, pileCardCount),
+	 (char*)src + offsetof(struct gameState, pileCardCount),
+	 sizeof(struct gameState) - offsetof(struct gameState, pileCardCount));
+}
+
+int resetGame(struct gamePool *pool, struct gameState *state) {
+  pool = poolOrDefault(pool);
+  //the saved position means nothing to another generator
+  if (pool == NULL || !pool->hasTemplate
+      || GetGeneratorCtx(NULL) != pool->templateGenerator)
+    {
+      return -1;
+    }
+  copyLiveState(state, &pool->template);
+  SetPositionCtx(NULL, &pool->templateRng);
+  return 0;
+}
+
 struct gameState* newGame() {
-  struct gameState* g = malloc(sizeof(struct gameState));
-  return g;
+  return acquireGame(NULL);
 }
 
 int* kingdomCards(int k1, int k2, int k3, int k4, int k5, int k6, int k7,
 		  int k8, int k9, int k10) {
-  int* k = malloc(10 * sizeof(int));
+  int* k = acquireKingdomCards(NULL);
+  if (k == NULL)
+    {
+      return NULL;
+    }
   k[0] = k1;
   k[1] = k2;
   k[2] = k3;
@@ -36,22 +417,15 @@ int* kingdomCards(int k1, int k2, int k3, int k4, int k5, int k6, int k7,
 
 int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
 		   struct gameState *state) {
+  return initializeGameWithRng(numPlayers, kingdomCards, randomSeed, NULL, state);
+}
+
+//supply piles and embargo tokens for a new game, -1 if the kingdom
+//cards are not all different
+static int setupSupply(int numPlayers, int kingdomCards[10], struct gameState *state) {
 
   int i;
   int j;
-  int it;			
-  //set up random number generator
-  SelectStream(1);
-  PutSeed((long)randomSeed);
-  
-  //check number of players
-  if (numPlayers > MAX_PLAYERS || numPlayers < 2)
-    {
-      return -1;
-    }
-
-  //set number of players
-  state->numPlayers = numPlayers;
 
   //check selected kingdom cards are different
   for (i = 0; i < 10; i++)
@@ -69,84 +443,55 @@ int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
   //initialize supply
   ///////////////////////////////
 
-  //set number of Curse cards
-  if (numPlayers == 2)
-    {
-      state->supplyCount[curse] = 10;
-    }
-  else if (numPlayers == 3)
-    {
-      state->supplyCount[curse] = 20;
-    }
-  else
-    {
-      state->supplyCount[curse] = 30;
-    }
-
-  //set number of Victory cards
-  if (numPlayers == 2)
-    {
-      state->supplyCount[estate] = 8;
-      state->supplyCount[duchy] = 8;
-      state->supplyCount[province] = 8;
-    }
-  else
-    {
-      state->supplyCount[estate] = 12;
-      state->supplyCount[duchy] = 12;
-      state->supplyCount[province] = 12;
-    }
-
-  //set number of Treasure cards
-  state->supplyCount[copper] = 60 - (7 * numPlayers);
-  state->supplyCount[silver] = 40;
-  state->supplyCount[gold] = 30;
-
-  //set number of Kingdom cards
-  for (i = adventurer; i <= treasure_map; i++)       	//loop all cards
+  //base cards always, kingdom cards only if chosen
+  for (i = curse; i <= treasure_map; i++)
     {
-      for (j = 0; j < 10; j++)           		//loop chosen cards
+      state->supplyCount[i] = (i < adventurer) ? cardTable[i].supply[numPlayers] : -1;
+      for (j = 0; j < 10; j++)
 	{
 	  if (kingdomCards[j] == i)
 	    {
-	      //check if card is a 'Victory' Kingdom card
-	      if (kingdomCards[j] == great_hall || kingdomCards[j] == gardens)
-		{
-		  if (numPlayers == 2){ 
-		    state->supplyCount[i] = 8; 
-		  }
-		  else{ state->supplyCount[i] = 12; }
-		}
-	      else
-		{
-		  state->supplyCount[i] = 10;
-		}
-	      break;
-	    }
-	  else    //card is not in the set choosen for the game
-	    {
-	      state->supplyCount[i] = -1;
+	      state->supplyCount[i] = cardTable[i].supply[numPlayers];
 	    }
 	}
-
     }
 
   ////////////////////////
   //supply intilization complete
 
+  //set embargo tokens to 0 for all supply piles
+  for (i = 0; i <= treasure_map; i++)
+    {
+      state->embargoTokens[i] = 0;
+    }
+
+  return 0;
+}
+
+//every player's starting deck, shuffled; the only part of a new game
+//that depends on the seed
+static int dealDecks(int numPlayers, struct gameState *state) {
+
+  int i;
+  int j;
+
   //set player decks
+  memset(state->pileCardCount, 0, sizeof(state->pileCardCount));
+  memset(state->fullCardCount, 0, sizeof(state->fullCardCount));
+  memset(state->shuffles, 0, sizeof(state->shuffles));
+  memset(state->deckKnown, 0, sizeof(state->deckKnown));
   for (i = 0; i < numPlayers; i++)
     {
       state->deckCount[i] = 0;
+      state->handCount[i] = 0;
+      state->discardCount[i] = 0;
       for (j = 0; j < 3; j++)
 	{
-	  state->deck[i][j] = estate;
-	  state->deckCount[i]++;
+	  pushCard(estate, deck_pile, i, state);
 	}
       for (j = 3; j < 10; j++)
 	{
-	  state->deck[i][j] = copper;
-	  state->deckCount[i]++;		
+	  pushCard(copper, deck_pile, i, state);
 	}
     }
 
@@ -159,8 +504,17 @@ int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
 	}
     }
 
+  return 0;
+}
+
+//first player's turn, from dealt decks
+static void startGame(struct gameState *state) {
+
+  int i;
+  int it;			
+
   //draw player hands
-  for (i = 0; i < numPlayers; i++)
+  for (i = 0; i < state->numPlayers; i++)
     {  
       //initialize hand size to zero
       state->handCount[i] = 0;
@@ -171,12 +525,6 @@ int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
       //	  drawCard(i, state);
       //	}
     }
-  
-  //set embargo tokens to 0 for all supply piles
-  for (i = 0; i <= treasure_map; i++)
-    {
-      state->embargoTokens[i] = 0;
-    }
 
   //initialize first player's turn
   state->outpostPlayed = 0;
@@ -188,84 +536,355 @@ int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
   state->handCount[state->whoseTurn] = 0;
   //int it; move to top
 
+  //supply and piles above were set directly, hash them once
+  syncGameState(state);
+
   //Moved draw cards to here, only drawing at the start of a turn
   for (it = 0; it < 5; it++){
     drawCard(state->whoseTurn, state);
   }
 
   updateCoins(state->whoseTurn, state, 0);
-
-  return 0;
 }
 
-int shuffle(int player, struct gameState *state) {
- 
+//initializeGameWithRng, keying shuffles by crnSeed unless it is 0
+static int setupGame(int numPlayers, int kingdomCards[10], int randomSeed,
+		     int crnSeed, RngState *rng, struct gameState *state) {
 
-  int newDeck[MAX_DECK];
-  int newDeckPos = 0;
-  int card;
-  int i;
+  //set up random number generator
+  SelectStreamCtx(rng, 1);
+  PutSeedCtx(rng, (long)randomSeed);
+  
+  //check number of players
+  if (numPlayers > MAX_PLAYERS || numPlayers < 2)
+    {
+      return -1;
+    }
 
-  if (state->deckCount[player] < 1)
-    return -1;
-  qsort ((void*)(state->deck[player]), state->deckCount[player], sizeof(int), compare); 
-  /* SORT CARDS IN DECK TO ENSURE DETERMINISM! */
+  //set number of players
+  state->numPlayers = numPlayers;
+  state->journal = NULL;
+  state->rng = rng;
+  state->crnSeed = crnSeed;
 
-  while (state->deckCount[player] > 0) {
-    card = floor(Random() * state->deckCount[player]);
-    newDeck[newDeckPos] = state->deck[player][card];
-    newDeckPos++;
-    for (i = card; i < state->deckCount[player]-1; i++) {
-      state->deck[player][i] = state->deck[player][i+1];
+  if (setupSupply(numPlayers, kingdomCards, state) < 0
+      || dealDecks(numPlayers, state) < 0)
+    {
+      return -1;
     }
-    state->deckCount[player]--;
-  }
-  for (i = 0; i < newDeckPos; i++) {
-    state->deck[player][i] = newDeck[i];
-    state->deckCount[player]++;
-  }
+  startGame(state);
 
   return 0;
 }
 
-int playCard(int handPos, int choice1, int choice2, int choice3, struct gameState *state) 
-{	
-  int card;
-  int coin_bonus = 0; 		//tracks coins gain from actions
+int initializeGameWithRng(int numPlayers, int kingdomCards[10], int randomSeed,
+			  RngState *rng, struct gameState *state) {
+  return setupGame(numPlayers, kingdomCards, randomSeed, 0, rng, state);
+}
 
-  //check if it is the right phase
-  if (state->phase != 0)
+int initializeGameCrn(int numPlayers, int kingdomCards[10], int randomSeed,
+		      RngState *rng, struct gameState *state) {
+  if (randomSeed <= 0)
     {
       return -1;
     }
-	
-  //check if player has enough actions
-  if ( state->numActions < 1 )
+  return setupGame(numPlayers, kingdomCards, randomSeed, randomSeed, rng, state);
+}
+
+#define START_DECK 10 /* 3 estates, 7 coppers */
+
+struct opening {
+  int used;
+  int numPlayers;
+  int randomSeed;
+  int generator; //of the context the decks were shuffled with
+  RngPosition rng; //stream 1 right after the decks were shuffled
+  int deck[MAX_PLAYERS][START_DECK];
+};
+
+struct openingCache {
+  struct opening* slots; //open addressing, capacity a power of 2
+  int capacity;
+  int count;
+};
+
+struct openingCache* newOpeningCache() {
+  return calloc(1, sizeof(struct openingCache));
+}
+
+int freeOpeningCache(struct openingCache *cache) {
+  if (cache == NULL)
     {
       return -1;
     }
-	
-  //get card played
-  card = handCard(handPos, state);
-	
-  //check if selected card is an action
-  if ( card < adventurer || card > treasure_map )
+  free(cache->slots);
+  free(cache);
+  return 0;
+}
+
+//slot holding the key, or the empty slot where it goes
+static struct opening* findOpening(struct openingCache *cache, int numPlayers,
+				   int randomSeed, int generator) {
+  int i = hashKey(randomSeed, numPlayers + (generator << 8)) & (cache->capacity - 1);
+
+  while (cache->slots[i].used
+	 && (cache->slots[i].numPlayers != numPlayers
+	     || cache->slots[i].randomSeed != randomSeed
+	     || cache->slots[i].generator != generator))
     {
-      return -1;
+      i = (i + 1) & (cache->capacity - 1);
     }
-	
-  //play card
-  if ( cardEffect(card, choice1, choice2, choice3, state, handPos, &coin_bonus) < 0 )
+  return &cache->slots[i];
+}
+
+//double the table, -1 if out of memory
+static int growOpeningCache(struct openingCache *cache) {
+  struct opening* old = cache->slots;
+  int oldCapacity = cache->capacity;
+  int i;
+
+  cache->capacity = (oldCapacity < 64) ? 64 : 2 * oldCapacity;
+  cache->slots = calloc(cache->capacity, sizeof(struct opening));
+  if (cache->slots == NULL)
     {
+      cache->slots = old;
+      cache->capacity = oldCapacity;
       return -1;
     }
-	
-  //reduce number of actions
-  state->numActions--;
-
-  //update coins (Treasure cards may be added with card draws)
-  updateCoins(state->whoseTurn, state, coin_bonus);
-	
+  for (i = 0; i < oldCapacity; i++)
+    {
+      if (old[i].used)
+	{
+	  *findOpening(cache, old[i].numPlayers, old[i].randomSeed,
+		       old[i].generator) = old[i];
+	}
+    }
+  free(old);
+  return 0;
+}
+
+int initializeGameCached(struct openingCache *cache, int numPlayers,
+			 int kingdomCards[10], int randomSeed, RngState *rng,
+			 struct gameState *state) {
+
+  struct opening* opening;
+  int i;
+
+  if (cache == NULL)
+    {
+      return -1;
+    }
+  if (2 * (cache->count + 1) > cache->capacity && growOpeningCache(cache) < 0)
+    {
+      return initializeGameWithRng(numPlayers, kingdomCards, randomSeed, rng, state);
+    }
+
+  //same start as initializeGameWithRng, planting the streams if need be
+  SelectStreamCtx(rng, 1);
+  PutSeedCtx(rng, (long)randomSeed);
+  if (numPlayers > MAX_PLAYERS || numPlayers < 2)
+    {
+      return -1;
+    }
+  state->numPlayers = numPlayers;
+  state->journal = NULL;
+  state->rng = rng;
+  state->crnSeed = 0;
+  if (setupSupply(numPlayers, kingdomCards, state) < 0)
+    {
+      return -1;
+    }
+
+  //a deal and a stream position only replay on the generator that made them
+  opening = findOpening(cache, numPlayers, randomSeed, GetGeneratorCtx(rng));
+  if (!opening->used)
+    {
+      if (dealDecks(numPlayers, state) < 0)
+	{
+	  return -1;
+	}
+      opening->used = 1;
+      opening->numPlayers = numPlayers;
+      opening->randomSeed = randomSeed;
+      opening->generator = GetGeneratorCtx(rng);
+      GetPositionCtx(rng, &opening->rng);
+      for (i = 0; i < numPlayers; i++)
+	{
+	  memcpy(opening->deck[i], state->deck[i], sizeof(opening->deck[i]));
+	}
+      cache->count++;
+    }
+  else
+    {
+      //what dealDecks leaves behind, without the shuffles
+      memset(state->pileCardCount, 0, sizeof(state->pileCardCount));
+      memset(state->fullCardCount, 0, sizeof(state->fullCardCount));
+      memset(state->shuffles, 0, sizeof(state->shuffles));
+      memset(state->deckKnown, 0, sizeof(state->deckKnown));
+      for (i = 0; i < numPlayers; i++)
+	{
+	  state->shuffles[i] = 1;
+	  memcpy(state->deck[i], opening->deck[i], sizeof(opening->deck[i]));
+	  state->deckCount[i] = START_DECK;
+	  state->handCount[i] = 0;
+	  state->discardCount[i] = 0;
+	  state->dirtyPiles |= pileBit(deck_pile, i);
+	}
+      SetPositionCtx(rng, &opening->rng);
+    }
+  startGame(state);
+
+  return 0;
+}
+
+#define CRN_STREAM 128 /* stream of player 0 in common random numbers mode */
+
+//in common random numbers mode (crnSeed not 0), switch to the player's own
+//stream seeded for the given shuffle count and draw; returns the stream to
+//go back to, -1 outside that mode
+int enterCrnStream(int crnSeed, int player, int shuffles, int draw, RngState *rng)
+{
+  unsigned long long key;
+  int stream;
+
+  if (crnSeed == 0)
+    {
+      return -1;
+    }
+  key = hashKey(crnSeed, player);
+  key = hashKey((int)key ^ shuffles, (int)(key >> 32) ^ draw);
+  stream = GetStreamCtx(rng);
+  SelectStreamCtx(rng, CRN_STREAM + player);
+  PutSeedCtx(rng, 1 + (long)(key % 2147483646)); //Lehmer seeds are 1..2^31-2
+  return stream;
+}
+
+void leaveCrnStream(int stream, RngState *rng)
+{
+  if (stream >= 0)
+    {
+      SelectStreamCtx(rng, stream);
+    }
+}
+
+int shuffle(int player, struct gameState *state) {
+ 
+
+  int deckCount = state->deckCount[player];
+#if !defined(LAZY_SHUFFLE)
+  int stream;
+#endif
+#if defined(LAZY_SHUFFLE)
+#elif defined(LEGACY_SHUFFLE)
+  int card;
+  int i;
+  double draws[MAX_DECK];
+  int deck[MAX_DECK];
+  int newDeck[MAX_DECK];
+  int newDeckPos = 0;
+#else
+  int card;
+  int i;
+  int newCard;
+#endif
+
+  //only permutes the deck, so the cached card counts are unaffected
+  if (deckCount < 1)
+    return -1;
+  state->dirtyPiles |= pileBit(deck_pile, player);
+  store(&state->deckKnown[player], 0, state);
+  store(&state->shuffles[player], state->shuffles[player] + 1, state);
+#if defined(LAZY_SHUFFLE)
+  //no known cards left, drawing picks from the whole deck
+#elif defined(LEGACY_SHUFFLE)
+  //shuffle a copy so the state sees one write per card
+  memcpy(deck, state->deck[player], sizeof(int) * deckCount);
+  qsort ((void*)deck, deckCount, sizeof(int), compare); 
+  /* SORT CARDS IN DECK TO ENSURE DETERMINISM! */
+
+  //one draw per card, taken from the stream all at once
+  stream = enterCrnStream(state->crnSeed, player, state->shuffles[player], 0,
+			  state->rng);
+  RandomFill(state->rng, draws, deckCount);
+  leaveCrnStream(stream, state->rng);
+  while (deckCount > 0) {
+    card = floor(draws[newDeckPos] * deckCount);
+    newDeck[newDeckPos] = deck[card];
+    newDeckPos++;
+    for (i = card; i < deckCount-1; i++) {
+      deck[i] = deck[i+1];
+    }
+    deckCount--;
+  }
+  for (i = 0; i < newDeckPos; i++) {
+    state->hash ^= cardKey(state->deck[player][i], i, deck_pile, player);
+    state->hash ^= cardKey(newDeck[i], i, deck_pile, player);
+    store(&state->deck[player][i], newDeck[i], state);
+  }
+#else
+  //Fisher-Yates in place: the deck order is already a function of the
+  //seed, so there is no need to sort it first
+  stream = enterCrnStream(state->crnSeed, player, state->shuffles[player], 0,
+			  state->rng);
+  for (i = deckCount - 1; i > 0; i--) {
+    card = RandomInt(state->rng, i + 1);
+    if (card == i)
+      continue;
+    newCard = state->deck[player][card];
+    state->hash ^= cardKey(newCard, card, deck_pile, player)
+      ^ cardKey(state->deck[player][i], i, deck_pile, player)
+      ^ cardKey(newCard, i, deck_pile, player)
+      ^ cardKey(state->deck[player][i], card, deck_pile, player);
+    store(&state->deck[player][card], state->deck[player][i], state);
+    store(&state->deck[player][i], newCard, state);
+  }
+  leaveCrnStream(stream, state->rng);
+#endif
+
+  return 0;
+}
+
+int playCard(int handPos, int choice1, int choice2, int choice3, struct gameState *state) 
+{	
+  int card;
+  int coin_bonus = 0; 		//tracks coins gain from actions
+
+  //check if it is the right phase
+  if (state->phase != 0)
+    {
+      return -1;
+    }
+	
+  //check if player has enough actions
+  if ( state->numActions < 1 )
+    {
+      return -1;
+    }
+	
+  //get card played
+  card = handCard(handPos, state);
+	
+  //check if selected card is an action
+  if ( card < adventurer || card > treasure_map )
+    {
+      return -1;
+    }
+	
+  //play card
+  if ( cardEffect(card, choice1, choice2, choice3, state, handPos, &coin_bonus) < 0 )
+    {
+      return -1;
+    }
+	
+  //reduce number of actions
+  store(&state->numActions, state->numActions - 1, state);
+
+  //treasure drawn or trashed is already in coins, add what the card gave
+  if (coin_bonus != 0)
+    {
+      addBonusCoins(coin_bonus, state);
+    }
+	
   return 0;
 }
 
@@ -292,12 +911,12 @@ int buyCard(int supplyPos, struct gameState *state) {
       printf("You do not have enough money to buy that. You have %d coins.\n", state->coins);
     return -1;
   } else {
-    state->phase=1;
+    store(&state->phase, 1, state);
     //state->supplyCount[supplyPos]--;
     gainCard(supplyPos, state, 0, who); //card goes in discard, this might be wrong.. (2 means goes into hand, 0 goes into discard)
   
-    state->coins = (state->coins) - (getCost(supplyPos));
-    state->numBuys--;
+    store(&state->coins, (state->coins) - (getCost(supplyPos)), state);
+    store(&state->numBuys, state->numBuys - 1, state);
     if (DEBUG)
       printf("You bought card number %d for %d coins. You now have %d buys and %d coins.\n", supplyPos, getCost(supplyPos), state->numBuys, state->coins);
   }
@@ -325,6 +944,11 @@ int fullDeckCount(int player, int card, struct gameState *state) {
   int i;
   int count = 0;
 
+  if (card >= curse && card <= treasure_map)
+    {
+      return state->fullCardCount[player][card];
+    }
+
   for (i = 0; i < state->deckCount[player]; i++)
     {
       if (state->deck[player][i] == card) count++;
@@ -354,26 +978,26 @@ int endTurn(struct gameState *state) {
   
   //Discard hand
   for (i = 0; i < state->handCount[currentPlayer]; i++){
-    state->discard[currentPlayer][state->discardCount[currentPlayer]++] = state->hand[currentPlayer][i];//Discard
-    state->hand[currentPlayer][i] = -1;//Set card to -1
+    pushCard(state->hand[currentPlayer][i], discard_pile, currentPlayer, state);//Discard
+    setPileCard(i, -1, hand_pile, currentPlayer, state);//Set card to -1
   }
-  state->handCount[currentPlayer] = 0;//Reset hand count
+  setPileCount(0, hand_pile, currentPlayer, state);//Reset hand count
     
   //Code for determining the player
   if (currentPlayer < (state->numPlayers - 1)){ 
-    state->whoseTurn = currentPlayer + 1;//Still safe to increment
+    store(&state->whoseTurn, currentPlayer + 1, state);//Still safe to increment
   }
   else{
-    state->whoseTurn = 0;//Max player has been reached, loop back around to player 1
+    store(&state->whoseTurn, 0, state);//Max player has been reached, loop back around to player 1
   }
 
-  state->outpostPlayed = 0;
-  state->phase = 0;
-  state->numActions = 1;
-  state->coins = 0;
-  state->numBuys = 1;
-  state->playedCardCount = 0;
-  state->handCount[state->whoseTurn] = 0;
+  store(&state->outpostPlayed, 0, state);
+  store(&state->phase, 0, state);
+  store(&state->numActions, 1, state);
+  store(&state->coins, 0, state);
+  store(&state->numBuys, 1, state);
+  setPileCount(0, played_pile, 0, state);
+  setPileCount(0, hand_pile, state->whoseTurn, state);
 
   //int k; move to top
   //Next player draws hand
@@ -384,74 +1008,22 @@ int endTurn(struct gameState *state) {
   //Update money
   updateCoins(state->whoseTurn, state , 0);
 
+  if (DEBUG && checkGameState(state) < 0){//Debug statements
+    printf("Cached card counts out of step after endTurn\n");
+  }
+
   return 0;
 }
 
 int isGameOver(struct gameState *state) {
-  int i;
-  int j;
-	
-  //if stack of Province cards is empty, the game ends
-  if (state->supplyCount[province] == 0)
-    {
-      return 1;
-    }
-
-  //if three supply pile are at 0, the game ends
-  j = 0;
-  for (i = 0; i < 25; i++)
-    {
-      if (state->supplyCount[i] == 0)
-	{
-	  j++;
-	}
-    }
-  if ( j >= 3)
-    {
-      return 1;
-    }
-
-  return 0;
+  //if stack of Province cards is empty, or three supply piles are, the game ends
+  return state->supplyCount[province] == 0 || state->emptyPiles >= 3;
 }
 
 int scoreFor (int player, struct gameState *state) {
-
-  int i;
-  int score = 0;
-  //score from hand
-  for (i = 0; i < state->handCount[player]; i++)
-    {
-      if (state->hand[player][i] == curse) { score = score - 1; };
-      if (state->hand[player][i] == estate) { score = score + 1; };
-      if (state->hand[player][i] == duchy) { score = score + 3; };
-      if (state->hand[player][i] == province) { score = score + 6; };
-      if (state->hand[player][i] == great_hall) { score = score + 1; };
-      if (state->hand[player][i] == gardens) { score = score + ( fullDeckCount(player, 0, state) / 10 ); };
-    }
-
-  //score from discard
-  for (i = 0; i < state->discardCount[player]; i++)
-    {
-      if (state->discard[player][i] == curse) { score = score - 1; };
-      if (state->discard[player][i] == estate) { score = score + 1; };
-      if (state->discard[player][i] == duchy) { score = score + 3; };
-      if (state->discard[player][i] == province) { score = score + 6; };
-      if (state->discard[player][i] == great_hall) { score = score + 1; };
-      if (state->discard[player][i] == gardens) { score = score + ( fullDeckCount(player, 0, state) / 10 ); };
-    }
-
-  //score from deck
-  for (i = 0; i < state->discardCount[player]; i++)
-    {
-      if (state->deck[player][i] == curse) { score = score - 1; };
-      if (state->deck[player][i] == estate) { score = score + 1; };
-      if (state->deck[player][i] == duchy) { score = score + 3; };
-      if (state->deck[player][i] == province) { score = score + 6; };
-      if (state->deck[player][i] == great_hall) { score = score + 1; };
-      if (state->deck[player][i] == gardens) { score = score + ( fullDeckCount(player, 0, state) / 10 ); };
-    }
-
-  return score;
+  //Gardens are worth 1 VP per 10 cards, countCard() keeps the rest
+  return state->victoryPoints[player]
+    + state->fullCardCount[player][gardens] * (state->cardTotal[player] / 10);
 }
 
 int getWinners(int players[MAX_PLAYERS], struct gameState *state) {
@@ -522,6 +1094,41 @@ int getWinners(int players[MAX_PLAYERS], struct gameState *state) {
   return 0;
 }
 
+#ifdef LAZY_SHUFFLE
+//move a random card from positions 0..pos of a deck to pos
+static void pickDeckCard(int pos, int player, struct gameState *state)
+{
+  //each unseen position gets a draw of its own under common random numbers
+  int stream = enterCrnStream(state->crnSeed, player, state->shuffles[player], pos,
+			      state->rng);
+  int pick = RandomInt(state->rng, pos + 1);
+  int card = state->deck[player][pick];
+
+  leaveCrnStream(stream, state->rng);
+
+  if (pick != pos)
+    {
+      setPileCard(pick, state->deck[player][pos], deck_pile, player, state);
+      setPileCard(pos, card, deck_pile, player, state);
+    }
+}
+#endif
+
+//top card of a non-empty deck; a lazily shuffled deck deals it now
+static int deckTop(int player, struct gameState *state)
+{
+  int count = state->deckCount[player];
+
+#ifdef LAZY_SHUFFLE
+  if (count > 0 && state->deckKnown[player] == 0)
+    {
+      pickDeckCard(count - 1, player, state);
+      store(&state->deckKnown[player], 1, state);
+    }
+#endif
+  return state->deck[player][count - 1];
+}
+
 int drawCard(int player, struct gameState *state)
 {	int count;
   int deckCounter;
@@ -531,12 +1138,12 @@ int drawCard(int player, struct gameState *state)
     int i;
     //Move discard to deck
     for (i = 0; i < state->discardCount[player];i++){
-      state->deck[player][i] = state->discard[player][i];
-      state->discard[player][i] = -1;
+      setPileCard(i, state->discard[player][i], deck_pile, player, state);
+      setPileCard(i, -1, discard_pile, player, state);
     }
 
-    state->deckCount[player] = state->discardCount[player];
-    state->discardCount[player] = 0;//Reset discard
+    setPileCount(state->discardCount[player], deck_pile, player, state);
+    setPileCount(0, discard_pile, player, state);//Reset discard
 
     //Shufffle the deck
     shuffle(player, state);//Shuffle the deck up and make it so that we can draw
@@ -545,8 +1152,6 @@ int drawCard(int player, struct gameState *state)
       printf("Deck count now: %d\n", state->deckCount[player]);
     }
     
-    state->discardCount[player] = 0;
-
     //Step 2 Draw Card
     count = state->handCount[player];//Get current player's hand count
     
@@ -559,9 +1164,9 @@ int drawCard(int player, struct gameState *state)
     if (deckCounter == 0)
       return -1;
 
-    state->hand[player][count] = state->deck[player][deckCounter - 1];//Add card to hand
-    state->deckCount[player]--;
-    state->handCount[player]++;//Increment hand count
+    setPileCard(count, deckTop(player, state), hand_pile, player, state);//Add card to hand
+    setPileCount(deckCounter - 1, deck_pile, player, state);
+    setPileCount(count + 1, hand_pile, player, state);//Increment hand count
   }
 
   else{
@@ -572,758 +1177,1601 @@ int drawCard(int player, struct gameState *state)
     }
 
     deckCounter = state->deckCount[player];//Create holder for the deck count
-    state->hand[player][count] = state->deck[player][deckCounter - 1];//Add card to the hand
-    state->deckCount[player]--;
-    state->handCount[player]++;//Increment hand count
+    setPileCard(count, deckTop(player, state), hand_pile, player, state);//Add card to the hand
+    setPileCount(deckCounter - 1, deck_pile, player, state);
+    setPileCount(count + 1, hand_pile, player, state);//Increment hand count
   }
 
   return 0;
 }
 
+#define KINGDOM {0, 0, 10, 10, 10, 10, 10}
+#define KINGDOM_VICTORY {0, 0, 8, 12, 12, 12, 12}
+
+const struct cardInfo cardTable[treasure_map+1] = {
+  /* name            cost  types                        coins  vp  supply */
+  {"Curse",          0, CURSE_CARD,                     0, -1, {0, 0, 10, 20, 30, 40, 50}},
+  {"Estate",         2, VICTORY_CARD,                   0,  1, {0, 0, 8, 12, 12, 12, 12}},
+  {"Duchy",          5, VICTORY_CARD,                   0,  3, {0, 0, 8, 12, 12, 12, 12}},
+  {"Province",       8, VICTORY_CARD,                   0,  6, {0, 0, 8, 12, 12, 15, 18}},
+  {"Copper",         0, TREASURE_CARD,                  1,  0, {0, 0, 46, 39, 32, 25, 18}},
+  {"Silver",         3, TREASURE_CARD,                  2,  0, {0, 0, 40, 40, 40, 40, 40}},
+  {"Gold",           6, TREASURE_CARD,                  3,  0, {0, 0, 30, 30, 30, 30, 30}},
+  {"Adventurer",     6, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Council Room",   5, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Feast",          4, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Gardens",        4, VICTORY_CARD,                   0,  0, KINGDOM_VICTORY},
+  {"Mine",           5, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Remodel",        4, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Smithy",         4, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Village",        3, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Baron",          4, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Great Hall",     3, ACTION_CARD | VICTORY_CARD,     0,  1, KINGDOM_VICTORY},
+  {"Minion",         5, ACTION_CARD | ATTACK_CARD,      0,  0, KINGDOM},
+  {"Steward",        3, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Tribute",        5, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Ambassador",     3, ACTION_CARD | ATTACK_CARD,      0,  0, KINGDOM},
+  {"Cutpurse",       4, ACTION_CARD | ATTACK_CARD,      0,  0, KINGDOM},
+  {"Embargo",        2, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Outpost",        5, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Salvager",       4, ACTION_CARD,                    0,  0, KINGDOM},
+  {"Sea Hag",        4, ACTION_CARD | ATTACK_CARD,      0,  0, KINGDOM},
+  {"Treasure Map",   4, ACTION_CARD,                    0,  0, KINGDOM}
+};
+
+//types of a card, 0 for an empty slot such as -1
+static int cardTypes(int card)
+{
+  return VALID_CARD(card) ? cardTable[card].types : 0;
+}
+
 int getCost(int cardNumber)
 {
-  switch( cardNumber ) 
-    {
-    case curse:
-      return 0;
-    case estate:
-      return 2;
-    case duchy:
-      return 5;
-    case province:
-      return 8;
-    case copper:
-      return 0;
-    case silver:
-      return 3;
-    case gold:
-      return 6;
-    case adventurer:
-      return 6;
-    case council_room:
-      return 5;
-    case feast:
-      return 4;
-    case gardens:
-      return 4;
-    case mine:
-      return 5;
-    case remodel:
-      return 4;
-    case smithy:
-      return 4;
-    case village:
-      return 3;
-    case baron:
-      return 4;
-    case great_hall:
-      return 3;
-    case minion:
-      return 5;
-    case steward:
-      return 3;
-    case tribute:
-      return 5;
-    case ambassador:
-      return 3;
-    case cutpurse:
-      return 4;
-    case embargo: 
-      return 2;
-    case outpost:
-      return 5;
-    case salvager:
-      return 4;
-    case sea_hag:
-      return 4;
-    case treasure_map:
-      return 4;
-    }
-	
-  return -1;
+  return VALID_CARD(cardNumber) ? cardTable[cardNumber].cost : -1;
 }
 
-int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState *state, int handPos, int *bonus)
+static int adventurerEffect(int choice1, int choice2, int choice3,
+			    struct gameState *state, int handPos, int *bonus)
 {
-  int i;
-  int j;
-  int k;
-  int x;
-  int index;
   int currentPlayer = whoseTurn(state);
-  int nextPlayer = currentPlayer + 1;
-
-  int tributeRevealedCards[2] = {-1, -1};
-  int temphand[MAX_HAND];// moved above the if statement
+  int temphand[MAX_HAND];
   int drawntreasure=0;
   int cardDrawn;
   int z = 0;// this is the counter for the temp hand
-  if (nextPlayer > (state->numPlayers - 1)){
-    nextPlayer = 0;
+
+  while(drawntreasure<2){
+    if (state->deckCount[currentPlayer] <1){//if the deck is empty we need to shuffle discard and add to deck
+      shuffle(currentPlayer, state);
+    }
+    drawCard(currentPlayer, state);
+    cardDrawn = state->hand[currentPlayer][state->handCount[currentPlayer]-1];//top card of hand is most recently drawn card.
+    if (cardTypes(cardDrawn) & TREASURE_CARD)
+      drawntreasure++;
+    else{
+      temphand[z]=cardDrawn;
+      popCard(hand_pile, currentPlayer, state); //this should just remove the top card (the most recently drawn one).
+      z++;
+    }
   }
-  
-	
-  //uses switch to select card and perform actions
-  switch( card ) 
-    {
-    case adventurer:
-      while(drawntreasure<2){
-	if (state->deckCount[currentPlayer] <1){//if the deck is empty we need to shuffle discard and add to deck
-	  shuffle(currentPlayer, state);
-	}
-	drawCard(currentPlayer, state);
-	cardDrawn = state->hand[currentPlayer][state->handCount[currentPlayer]-1];//top card of hand is most recently drawn card.
-	if (cardDrawn == copper || cardDrawn == silver || cardDrawn == gold)
-	  drawntreasure++;
-	else{
-	  temphand[z]=cardDrawn;
-	  state->handCount[currentPlayer]--; //this should just remove the top card (the most recently drawn one).
-	  z++;
-	}
-      }
-      while(z-1>=0){
-	state->discard[currentPlayer][state->discardCount[currentPlayer]++]=temphand[z-1]; // discard all cards in play that have been drawn
-	z=z-1;
-      }
-      return 0;
-			
-    case council_room:
-      //+4 Cards
-      for (i = 0; i < 4; i++)
-	{
-	  drawCard(currentPlayer, state);
-	}
-			
-      //+1 Buy
-      state->numBuys++;
-			
-      //Each other player draws a card
-      for (i = 0; i < state->numPlayers; i++)
-	{
-	  if ( i != currentPlayer )
-	    {
-	      drawCard(i, state);
-	    }
-	}
-			
-      //put played card in played card pile
-      discardCard(handPos, currentPlayer, state, 0);
-			
-      return 0;
-			
-    case feast:
-      //gain card with cost up to 5
-      //Backup hand
-      for (i = 0; i <= state->handCount[currentPlayer]; i++){
-	temphand[i] = state->hand[currentPlayer][i];//Backup card
-	state->hand[currentPlayer][i] = -1;//Set to nothing
-      }
-      //Backup hand
+  while(z-1>=0){
+    pushCard(temphand[z-1], discard_pile, currentPlayer, state); // discard all cards in play that have been drawn
+    z=z-1;
+  }
+  return 0;
+}
 
-      //Update Coins for Buy
-      updateCoins(currentPlayer, state, 5);
-      x = 1;//Condition to loop on
-      while( x == 1) {//Buy one card
-	if (supplyCount(choice1, state) <= 0){
-	  if (DEBUG)
-	    printf("None of that card left, sorry!\n");
+static int councilRoomEffect(int choice1, int choice2, int choice3,
+			     struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int currentPlayer = whoseTurn(state);
 
-	  if (DEBUG){
-	    printf("Cards Left: %d\n", supplyCount(choice1, state));
-	  }
-	}
-	else if (state->coins < getCost(choice1)){
-	  printf("That card is too expensive!\n");
+  //+4 Cards
+  for (i = 0; i < 4; i++)
+    {
+      drawCard(currentPlayer, state);
+    }
 
-	  if (DEBUG){
-	    printf("Coins: %d < %d\n", state->coins, getCost(choice1));
-	  }
-	}
-	else{
+  //+1 Buy
+  store(&state->numBuys, state->numBuys + 1, state);
 
-	  if (DEBUG){
-	    printf("Deck Count: %d\n", state->handCount[currentPlayer] + state->deckCount[currentPlayer] + state->discardCount[currentPlayer]);
-	  }
+  //Each other player draws a card
+  for (i = 0; i < state->numPlayers; i++)
+    {
+      if ( i != currentPlayer )
+	{
+	  drawCard(i, state);
+	}
+    }
 
-	  gainCard(choice1, state, 0, currentPlayer);//Gain the card
-	  x = 0;//No more buying cards
+  //put played card in played card pile
+  discardCard(handPos, currentPlayer, state, 0);
 
-	  if (DEBUG){
-	    printf("Deck Count: %d\n", state->handCount[currentPlayer] + state->deckCount[currentPlayer] + state->discardCount[currentPlayer]);
-	  }
+  return 0;
+}
 
-	}
-      }     
+static int feastEffect(int choice1, int choice2, int choice3,
+		       struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
 
-      //Reset Hand
-      for (i = 0; i <= state->handCount[currentPlayer]; i++){
-	state->hand[currentPlayer][i] = temphand[i];
-	temphand[i] = -1;
-      }
-      //Reset Hand
-      			
-      return 0;
-			
-    case gardens:
+  //gain card with cost up to 5; the feast pays, not the coins in hand
+  if (supplyCount(choice1, state) <= 0)
+    {
+      if (DEBUG)
+	printf("None of that card left, sorry!\n");
+      return -1;
+    }
+  if (getCost(choice1) > 5)
+    {
+      if (DEBUG)
+	printf("That card is too expensive!\n");
       return -1;
-			
-    case mine:
-      j = state->hand[currentPlayer][choice1];  //store card we will trash
+    }
+  gainCard(choice1, state, 0, currentPlayer);//Gain the card
 
-      if (state->hand[currentPlayer][choice1] < copper || state->hand[currentPlayer][choice1] > gold)
-	{
-	  return -1;
-	}
-		
-      if (choice2 > treasure_map || choice2 < curse)
-	{
-	  return -1;
-	}
+  return 0;
+}
 
-      if ( (getCost(state->hand[currentPlayer][choice1]) + 3) > getCost(choice2) )
-	{
-	  return -1;
-	}
+static int mineEffect(int choice1, int choice2, int choice3,
+		      struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int j;
+  int currentPlayer = whoseTurn(state);
 
-      gainCard(choice2, state, 2, currentPlayer);
+  j = state->hand[currentPlayer][choice1];  //store card we will trash
 
-      //discard card from hand
-      discardCard(handPos, currentPlayer, state, 0);
+  if (state->hand[currentPlayer][choice1] < copper || state->hand[currentPlayer][choice1] > gold)
+    {
+      return -1;
+    }
 
-      //discard trashed card
-      for (i = 0; i < state->handCount[currentPlayer]; i++)
-	{
-	  if (state->hand[currentPlayer][i] == j)
-	    {
-	      discardCard(i, currentPlayer, state, 0);			
-	      break;
-	    }
-	}
-			
-      return 0;
-			
-    case remodel:
-      j = state->hand[currentPlayer][choice1];  //store card we will trash
+  if (choice2 > treasure_map || choice2 < curse)
+    {
+      return -1;
+    }
 
-      if ( (getCost(state->hand[currentPlayer][choice1]) + 2) > getCost(choice2) )
-	{
-	  return -1;
-	}
+  if ( (getCost(state->hand[currentPlayer][choice1]) + 3) > getCost(choice2) )
+    {
+      return -1;
+    }
 
-      gainCard(choice2, state, 0, currentPlayer);
+  gainCard(choice2, state, 2, currentPlayer);
 
-      //discard card from hand
-      discardCard(handPos, currentPlayer, state, 0);
+  //discard card from hand
+  discardCard(handPos, currentPlayer, state, 0);
 
-      //discard trashed card
-      for (i = 0; i < state->handCount[currentPlayer]; i++)
+  //discard trashed card
+  for (i = 0; i < state->handCount[currentPlayer]; i++)
+    {
+      if (state->hand[currentPlayer][i] == j)
 	{
-	  if (state->hand[currentPlayer][i] == j)
-	    {
-	      discardCard(i, currentPlayer, state, 0);			
-	      break;
-	    }
+	  discardCard(i, currentPlayer, state, 0);                  
+	  break;
 	}
+    }
+
+  return 0;
+}
+
+static int remodelEffect(int choice1, int choice2, int choice3,
+			 struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int j;
+  int currentPlayer = whoseTurn(state);
+
+  j = state->hand[currentPlayer][choice1];  //store card we will trash
+
+  if ( (getCost(state->hand[currentPlayer][choice1]) + 2) > getCost(choice2) )
+    {
+      return -1;
+    }
 
+  gainCard(choice2, state, 0, currentPlayer);
 
-      return 0;
-		
-    case smithy:
-      //+3 Cards
-      for (i = 0; i < 3; i++)
+  //discard card from hand
+  discardCard(handPos, currentPlayer, state, 0);
+
+  //discard trashed card
+  for (i = 0; i < state->handCount[currentPlayer]; i++)
+    {
+      if (state->hand[currentPlayer][i] == j)
 	{
-	  drawCard(currentPlayer, state);
+	  discardCard(i, currentPlayer, state, 0);                  
+	  break;
 	}
-			
-      //discard card from hand
-      discardCard(handPos, currentPlayer, state, 0);
-      return 0;
-		
-    case village:
-      //+1 Card
+    }
+
+
+  return 0;
+}
+
+static int smithyEffect(int choice1, int choice2, int choice3,
+			struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int currentPlayer = whoseTurn(state);
+
+  //+3 Cards
+  for (i = 0; i < 3; i++)
+    {
       drawCard(currentPlayer, state);
-			
-      //+2 Actions
-      state->numActions = state->numActions + 2;
-			
-      //discard played card from hand
-      discardCard(handPos, currentPlayer, state, 0);
-      return 0;
-		
-    case baron:
-      state->numBuys++;//Increase buys by 1!
-      if (choice1 > 0){//Boolean true or going to discard an estate
-	int p = 0;//Iterator for hand!
-	int card_not_discarded = 1;//Flag for discard set!
-	while(card_not_discarded){
-	  if (state->hand[currentPlayer][p] == estate){//Found an estate card!
-	    state->coins += 4;//Add 4 coins to the amount of coins
-	    state->discard[currentPlayer][state->discardCount[currentPlayer]] = state->hand[currentPlayer][p];
-	    state->discardCount[currentPlayer]++;
-	    for (;p < state->handCount[currentPlayer]; p++){
-	      state->hand[currentPlayer][p] = state->hand[currentPlayer][p+1];
-	    }
-	    state->hand[currentPlayer][state->handCount[currentPlayer]] = -1;
-	    state->handCount[currentPlayer]--;
-	    card_not_discarded = 0;//Exit the loop
-	  }
-	  else if (p > state->handCount[currentPlayer]){
-	    if(DEBUG) {
-	      printf("No estate cards in your hand, invalid choice\n");
-	      printf("Must gain an estate if there are any\n");
-	    }
-	    if (supplyCount(estate, state) > 0){
-	      gainCard(estate, state, 0, currentPlayer);
-	      state->supplyCount[estate]--;//Decrement estates
-	      if (supplyCount(estate, state) == 0){
-		isGameOver(state);
-	      }
-	    }
-	    card_not_discarded = 0;//Exit the loop
-	  }
-			    
-	  else{
-	    p++;//Next card
-	  }
+    }
+
+  //discard card from hand
+  discardCard(handPos, currentPlayer, state, 0);
+  return 0;
+}
+
+static int villageEffect(int choice1, int choice2, int choice3,
+			 struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
+
+  //+1 Card
+  drawCard(currentPlayer, state);
+
+  //+2 Actions
+  store(&state->numActions, state->numActions + 2, state);
+
+  //discard played card from hand
+  discardCard(handPos, currentPlayer, state, 0);
+  return 0;
+}
+
+static int baronEffect(int choice1, int choice2, int choice3,
+		       struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
+
+  store(&state->numBuys, state->numBuys + 1, state);//Increase buys by 1!
+  if (choice1 > 0){//Boolean true or going to discard an estate
+    int p = 0;//Iterator for hand!
+    int card_not_discarded = 1;//Flag for discard set!
+    while(card_not_discarded){
+      if (state->hand[currentPlayer][p] == estate){//Found an estate card!
+	addBonusCoins(4, state);//Add 4 coins to the amount of coins
+	pushCard(state->hand[currentPlayer][p], discard_pile, currentPlayer, state);
+	for (;p < state->handCount[currentPlayer]; p++){
+	  setPileCard(p, state->hand[currentPlayer][p+1], hand_pile, currentPlayer, state);
 	}
+	setPileCard(state->handCount[currentPlayer], -1, hand_pile, currentPlayer, state);
+	popCard(hand_pile, currentPlayer, state);
+	card_not_discarded = 0;//Exit the loop
       }
-			    
-      else{
+      else if (p > state->handCount[currentPlayer]){
+	if(DEBUG) {
+	  printf("No estate cards in your hand, invalid choice\n");
+	  printf("Must gain an estate if there are any\n");
+	}
 	if (supplyCount(estate, state) > 0){
-	  gainCard(estate, state, 0, currentPlayer);//Gain an estate
-	  state->supplyCount[estate]--;//Decrement Estates
+	  gainCard(estate, state, 0, currentPlayer);
+	  setSupplyCount(estate, state->supplyCount[estate] - 1, state);//Decrement estates
 	  if (supplyCount(estate, state) == 0){
 	    isGameOver(state);
 	  }
 	}
+	card_not_discarded = 0;//Exit the loop
       }
-	    
-      
-      return 0;
-		
-    case great_hall:
-      //+1 Card
-      drawCard(currentPlayer, state);
-			
-      //+1 Actions
-      state->numActions++;
-			
-      //discard card from hand
-      discardCard(handPos, currentPlayer, state, 0);
-      return 0;
-		
-    case minion:
-      //+1 action
-      state->numActions++;
-			
-      //discard card from hand
-      discardCard(handPos, currentPlayer, state, 0);
-			
-      if (choice1)		//+2 coins
-	{
-	  state->coins = state->coins + 2;
-	}
-			
-      else if (choice2)		//discard hand, redraw 4, other players with 5+ cards discard hand and draw 4
-	{
-	  //discard hand
-	  while(numHandCards(state) > 0)
-	    {
-	      discardCard(handPos, currentPlayer, state, 0);
-	    }
-				
-	  //draw 4
-	  for (i = 0; i < 4; i++)
-	    {
-	      drawCard(currentPlayer, state);
-	    }
-				
-	  //other players discard hand and redraw if hand size > 4
-	  for (i = 0; i < state->numPlayers; i++)
-	    {
-	      if (i != currentPlayer)
-		{
-		  if ( state->handCount[i] > 4 )
-		    {
-		      //discard hand
-		      while( state->handCount[i] > 0 )
-			{
-			  discardCard(handPos, i, state, 0);
-			}
-							
-		      //draw 4
-		      for (j = 0; j < 4; j++)
-			{
-			  drawCard(i, state);
-			}
-		    }
-		}
-	    }
-				
-	}
-      return 0;
-		
-    case steward:
-      if (choice1 == 1)
-	{
-	  //+2 cards
-	  drawCard(currentPlayer, state);
-	  drawCard(currentPlayer, state);
-	}
-      else if (choice1 == 2)
-	{
-	  //+2 coins
-	  state->coins = state->coins + 2;
-	}
-      else
-	{
-	  //trash 2 cards in hand
-	  discardCard(choice2, currentPlayer, state, 1);
-	  discardCard(choice3, currentPlayer, state, 1);
-	}
-			
-      //discard card from hand
-      discardCard(handPos, currentPlayer, state, 0);
-      return 0;
-		
-    case tribute:
-      if ((state->discardCount[nextPlayer] + state->deckCount[nextPlayer]) <= 1){
-	if (state->deckCount[nextPlayer] > 0){
-	  tributeRevealedCards[0] = state->deck[nextPlayer][state->deckCount[nextPlayer]-1];
-	  state->deckCount[nextPlayer]--;
-	}
-	else if (state->discardCount[nextPlayer] > 0){
-	  tributeRevealedCards[0] = state->discard[nextPlayer][state->discardCount[nextPlayer]-1];
-	  state->discardCount[nextPlayer]--;
-	}
-	else{
-	  //No Card to Reveal
-	  if (DEBUG){
-	    printf("No cards to reveal\n");
-	  }
-	}
-      }
-	    
+
       else{
-	if (state->deckCount[nextPlayer] == 0){
-	  for (i = 0; i < state->discardCount[nextPlayer]; i++){
-	    state->deck[nextPlayer][i] = state->discard[nextPlayer][i];//Move to deck
-	    state->deckCount[nextPlayer]++;
-	    state->discard[nextPlayer][i] = -1;
-	    state->discardCount[nextPlayer]--;
-	  }
-			    
-	  shuffle(nextPlayer,state);//Shuffle the deck
-	} 
-	tributeRevealedCards[0] = state->deck[nextPlayer][state->deckCount[nextPlayer]-1];
-	state->deck[nextPlayer][state->deckCount[nextPlayer]--] = -1;
-	state->deckCount[nextPlayer]--;
-	tributeRevealedCards[1] = state->deck[nextPlayer][state->deckCount[nextPlayer]-1];
-	state->deck[nextPlayer][state->deckCount[nextPlayer]--] = -1;
-	state->deckCount[nextPlayer]--;
-      }    
-		       
-      if (tributeRevealedCards[0] == tributeRevealedCards[1]){//If we have a duplicate card, just drop one 
-	state->playedCards[state->playedCardCount] = tributeRevealedCards[1];
-	state->playedCardCount++;
-	tributeRevealedCards[1] = -1;
+	p++;//Next card
       }
+    }
+  }
 
-      for (i = 0; i <= 2; i ++){
-	if (tributeRevealedCards[i] == copper || tributeRevealedCards[i] == silver || tributeRevealedCards[i] == gold){//Treasure cards
-	  state->coins += 2;
-	}
-		    
-	else if (tributeRevealedCards[i] == estate || tributeRevealedCards[i] == duchy || tributeRevealedCards[i] == province || tributeRevealedCards[i] == gardens || tributeRevealedCards[i] == great_hall){//Victory Card Found
-	  drawCard(currentPlayer, state);
-	  drawCard(currentPlayer, state);
-	}
-	else{//Action Card
-	  state->numActions = state->numActions + 2;
-	}
+  else{
+    if (supplyCount(estate, state) > 0){
+      gainCard(estate, state, 0, currentPlayer);//Gain an estate
+      setSupplyCount(estate, state->supplyCount[estate] - 1, state);//Decrement Estates
+      if (supplyCount(estate, state) == 0){
+	isGameOver(state);
       }
-	    
-      return 0;
-		
-    case ambassador:
-      j = 0;		//used to check if player has enough cards to discard
+    }
+  }
 
-      if (choice2 > 2 || choice2 < 0)
-	{
-	  return -1;				
-	}
 
-      if (choice1 == handPos)
-	{
-	  return -1;
-	}
+  return 0;
+}
 
-      for (i = 0; i < state->handCount[currentPlayer]; i++)
-	{
-	  if (i != handPos && i == state->hand[currentPlayer][choice1] && i != choice1)
-	    {
-	      j++;
-	    }
-	}
-      if (j < choice2)
-	{
-	  return -1;				
-	}
+static int greatHallEffect(int choice1, int choice2, int choice3,
+			   struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
 
-      if (DEBUG) 
-	printf("Player %d reveals card number: %d\n", currentPlayer, state->hand[currentPlayer][choice1]);
+  //+1 Card
+  drawCard(currentPlayer, state);
 
-      //increase supply count for choosen card by amount being discarded
-      state->supplyCount[state->hand[currentPlayer][choice1]] += choice2;
-			
-      //each other player gains a copy of revealed card
-      for (i = 0; i < state->numPlayers; i++)
-	{
-	  if (i != currentPlayer)
-	    {
-	      gainCard(state->hand[currentPlayer][choice1], state, 0, i);
-	    }
-	}
+  //+1 Actions
+  store(&state->numActions, state->numActions + 1, state);
+
+  //discard card from hand
+  discardCard(handPos, currentPlayer, state, 0);
+  return 0;
+}
+
+static int minionEffect(int choice1, int choice2, int choice3,
+			struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int j;
+  int currentPlayer = whoseTurn(state);
+
+  //+1 action
+  store(&state->numActions, state->numActions + 1, state);
 
-      //discard played card from hand
-      discardCard(handPos, currentPlayer, state, 0);			
+  //discard card from hand
+  discardCard(handPos, currentPlayer, state, 0);
 
-      //trash copies of cards returned to supply
-      for (j = 0; j < choice2; j++)
+  if (choice1)              //+2 coins
+    {
+      addBonusCoins(2, state);
+    }
+
+  else if (choice2)         //discard hand, redraw 4, other players with 5+ cards discard hand and draw 4
+    {
+      //discard hand
+      while(numHandCards(state) > 0)
 	{
-	  for (i = 0; i < state->handCount[currentPlayer]; i++)
-	    {
-	      if (state->hand[currentPlayer][i] == state->hand[currentPlayer][choice1])
-		{
-		  discardCard(i, currentPlayer, state, 1);
-		  break;
-		}
-	    }
-	}			
+	  discardCard(handPos, currentPlayer, state, 0);
+	}
 
-      return 0;
-		
-    case cutpurse:
+      //draw 4
+      for (i = 0; i < 4; i++)
+	{
+	  drawCard(currentPlayer, state);
+	}
 
-      updateCoins(currentPlayer, state, 2);
+      //other players discard hand and redraw if hand size > 4
       for (i = 0; i < state->numPlayers; i++)
 	{
 	  if (i != currentPlayer)
 	    {
-	      for (j = 0; j < state->handCount[i]; j++)
+	      if ( state->handCount[i] > 4 )
 		{
-		  if (state->hand[i][j] == copper)
+		  //discard hand
+		  while( state->handCount[i] > 0 )
 		    {
-		      discardCard(j, i, state, 0);
-		      break;
+		      discardCard(handPos, i, state, 0);
 		    }
-		  if (j == state->handCount[i])
+
+		  //draw 4
+		  for (j = 0; j < 4; j++)
 		    {
-		      for (k = 0; k < state->handCount[i]; k++)
-			{
-			  if (DEBUG)
-			    printf("Player %d reveals card number %d\n", i, state->hand[i][k]);
-			}	
-		      break;
-		    }		
+		      drawCard(i, state);
+		    }
 		}
-					
-	    }
-				
-	}				
-
-      //discard played card from hand
-      discardCard(handPos, currentPlayer, state, 0);			
-
-      return 0;
-
-		
-    case embargo: 
-      //+2 Coins
-      state->coins = state->coins + 2;
-			
-      //see if selected pile is in play
-      if ( state->supplyCount[choice1] == -1 )
-	{
-	  return -1;
-	}
-			
-      //add embargo token to selected supply pile
-      state->embargoTokens[choice1]++;
-			
-      //trash card
-      discardCard(handPos, currentPlayer, state, 1);		
-      return 0;
-		
-    case outpost:
-      //set outpost flag
-      state->outpostPlayed++;
-			
-      //discard card
-      discardCard(handPos, currentPlayer, state, 0);
-      return 0;
-		
-    case salvager:
-      //+1 buy
-      state->numBuys++;
-			
-      if (choice1)
-	{
-	  //gain coins equal to trashed card
-	  state->coins = state->coins + getCost( handCard(choice1, state) );
-	  //trash card
-	  discardCard(choice1, currentPlayer, state, 1);	
-	}
-			
-      //discard card
-      discardCard(handPos, currentPlayer, state, 0);
-      return 0;
-		
-    case sea_hag:
-      for (i = 0; i < state->numPlayers; i++){
-	if (i != currentPlayer){
-	  state->discard[i][state->discardCount[i]] = state->deck[i][state->deckCount[i]--];			    state->deckCount[i]--;
-	  state->discardCount[i]++;
-	  state->deck[i][state->deckCount[i]--] = curse;//Top card now a curse
-	}
-      }
-      return 0;
-		
-    case treasure_map:
-      //search hand for another treasure_map
-      index = -1;
-      for (i = 0; i < state->handCount[currentPlayer]; i++)
-	{
-	  if (state->hand[currentPlayer][i] == treasure_map && i != handPos)
-	    {
-	      index = i;
-	      break;
 	    }
 	}
-      if (index > -1)
-	{
-	  //trash both treasure cards
-	  discardCard(handPos, currentPlayer, state, 1);
-	  discardCard(index, currentPlayer, state, 1);
 
-	  //gain 4 Gold cards
-	  for (i = 0; i < 4; i++)
-	    {
-	      gainCard(gold, state, 1, currentPlayer);
-	    }
-				
-	  //return success
-	  return 1;
-	}
-			
-      //no second treasure_map found in hand
-      return -1;
     }
-	
-  return -1;
+  return 0;
 }
 
-int discardCard(int handPos, int currentPlayer, struct gameState *state, int trashFlag)
+static int stewardEffect(int choice1, int choice2, int choice3,
+			 struct gameState *state, int handPos, int *bonus)
 {
-	
-  //if card is not trashed, added to Played pile 
-  if (trashFlag < 1)
-    {
-      //add card to played pile
-      state->playedCards[state->playedCardCount] = state->hand[currentPlayer][handPos]; 
-      state->playedCardCount++;
-    }
-	
-  //set played card to -1
-  state->hand[currentPlayer][handPos] = -1;
-	
-  //remove card from player's hand
-  if ( handPos == (state->handCount[currentPlayer] - 1) ) 	//last card in hand array is played
+  int currentPlayer = whoseTurn(state);
+
+  if (choice1 == 1)
     {
-      //reduce number of cards in hand
-      state->handCount[currentPlayer]--;
+      //+2 cards
+      drawCard(currentPlayer, state);
+      drawCard(currentPlayer, state);
     }
-  else if ( state->handCount[currentPlayer] == 1 ) //only one card in hand
+  else if (choice1 == 2)
     {
-      //reduce number of cards in hand
-      state->handCount[currentPlayer]--;
+      //+2 coins
+      addBonusCoins(2, state);
     }
-  else 	
+  else
     {
-      //replace discarded card with last card in hand
-      state->hand[currentPlayer][handPos] = state->hand[currentPlayer][ (state->handCount[currentPlayer] - 1)];
-      //set last card to -1
-      state->hand[currentPlayer][state->handCount[currentPlayer] - 1] = -1;
-      //reduce number of cards in hand
-      state->handCount[currentPlayer]--;
+      //trash 2 cards in hand
+      discardCard(choice2, currentPlayer, state, 1);
+      discardCard(choice3, currentPlayer, state, 1);
     }
-	
+
+  //discard card from hand
+  discardCard(handPos, currentPlayer, state, 0);
   return 0;
 }
 
-int gainCard(int supplyPos, struct gameState *state, int toFlag, int player)
+static int tributeEffect(int choice1, int choice2, int choice3,
+			 struct gameState *state, int handPos, int *bonus)
 {
-  //Note: supplyPos is enum of choosen card
-	
-  //check if supply pile is empty (0) or card is not used in game (-1)
-  if ( supplyCount(supplyPos, state) < 1 )
-    {
-      return -1;
+  int i;
+  int currentPlayer = whoseTurn(state);
+  int nextPlayer = currentPlayer + 1;
+  int tributeRevealedCards[2] = {-1, -1};
+
+  if (nextPlayer > (state->numPlayers - 1)){
+    nextPlayer = 0;
+  }
+
+  if ((state->discardCount[nextPlayer] + state->deckCount[nextPlayer]) <= 1){
+    if (state->deckCount[nextPlayer] > 0){
+      tributeRevealedCards[0] = popCard(deck_pile, nextPlayer, state);
     }
-	
-  //added card for [whoseTurn] current player:
-  // toFlag = 0 : add to discard
-  // toFlag = 1 : add to deck
-  // toFlag = 2 : add to hand
+    else if (state->discardCount[nextPlayer] > 0){
+      tributeRevealedCards[0] = popCard(discard_pile, nextPlayer, state);
+    }
+    else{
+      //No Card to Reveal
+      if (DEBUG){
+	printf("No cards to reveal\n");
+      }
+    }
+  }
 
-  if (toFlag == 1)
-    {
-      state->deck[ player ][ state->deckCount[player] ] = supplyPos;
-      state->deckCount[player]++;
+  else{
+    if (state->deckCount[nextPlayer] == 0){
+      for (i = 0; i < state->discardCount[nextPlayer]; i++){
+	pushCard(state->discard[nextPlayer][i], deck_pile, nextPlayer, state);//Move to deck
+	setPileCard(i, -1, discard_pile, nextPlayer, state);
+	popCard(discard_pile, nextPlayer, state);
+      }
+
+      shuffle(nextPlayer,state);//Shuffle the deck
+    } 
+    tributeRevealedCards[0] = deckTop(nextPlayer, state);
+    setPileCard(state->deckCount[nextPlayer], -1, deck_pile, nextPlayer, state);
+    popCard(deck_pile, nextPlayer, state);
+    popCard(deck_pile, nextPlayer, state);
+    tributeRevealedCards[1] = deckTop(nextPlayer, state);
+    setPileCard(state->deckCount[nextPlayer], -1, deck_pile, nextPlayer, state);
+    popCard(deck_pile, nextPlayer, state);
+    popCard(deck_pile, nextPlayer, state);
+  }    
+
+  if (tributeRevealedCards[0] == tributeRevealedCards[1]){//If we have a duplicate card, just drop one 
+    pushCard(tributeRevealedCards[1], played_pile, 0, state);
+    tributeRevealedCards[1] = -1;
+  }
+
+  for (i = 0; i < 2; i ++){
+    if (cardTypes(tributeRevealedCards[i]) & TREASURE_CARD){//Treasure cards
+      addBonusCoins(2, state);
     }
-  else if (toFlag == 2)
-    {
-      state->hand[ player ][ state->handCount[player] ] = supplyPos;
-      state->handCount[player]++;
+
+    else if (cardTypes(tributeRevealedCards[i]) & VICTORY_CARD){//Victory Card Found
+      drawCard(currentPlayer, state);
+      drawCard(currentPlayer, state);
     }
-  else
-    {
-      state->discard[player][ state->discardCount[player] ] = supplyPos;
-      state->discardCount[player]++;
+    else{//Action Card
+      store(&state->numActions, state->numActions + 2, state);
     }
-	
-  //decrease number in supply pile
-  state->supplyCount[supplyPos]--;
-	 
+  }
+
   return 0;
 }
 
-int updateCoins(int player, struct gameState *state, int bonus)
+static int ambassadorEffect(int choice1, int choice2, int choice3,
+			    struct gameState *state, int handPos, int *bonus)
 {
   int i;
-	
-  //reset coin count
-  state->coins = 0;
+  int j;
+  int currentPlayer = whoseTurn(state);
+
+  j = 0;            //used to check if player has enough cards to discard
+
+  if (choice2 > 2 || choice2 < 0)
+    {
+      return -1;                            
+    }
+
+  if (choice1 == handPos)
+    {
+      return -1;
+    }
+
+  for (i = 0; i < state->handCount[currentPlayer]; i++)
+    {
+      if (i != handPos && i == state->hand[currentPlayer][choice1] && i != choice1)
+	{
+	  j++;
+	}
+    }
+  if (j < choice2)
+    {
+      return -1;                            
+    }
+
+  if (DEBUG) 
+    printf("Player %d reveals card number: %d\n", currentPlayer, state->hand[currentPlayer][choice1]);
+
+  //increase supply count for choosen card by amount being discarded
+  setSupplyCount(state->hand[currentPlayer][choice1],
+		 state->supplyCount[state->hand[currentPlayer][choice1]] + choice2, state);
+
+  //each other player gains a copy of revealed card
+  for (i = 0; i < state->numPlayers; i++)
+    {
+      if (i != currentPlayer)
+	{
+	  gainCard(state->hand[currentPlayer][choice1], state, 0, i);
+	}
+    }
+
+  //discard played card from hand
+  discardCard(handPos, currentPlayer, state, 0);                    
+
+  //trash copies of cards returned to supply
+  for (j = 0; j < choice2; j++)
+    {
+      for (i = 0; i < state->handCount[currentPlayer]; i++)
+	{
+	  if (state->hand[currentPlayer][i] == state->hand[currentPlayer][choice1])
+	    {
+	      discardCard(i, currentPlayer, state, 1);
+	      break;
+	    }
+	}
+    }                       
+
+  return 0;
+}
+
+static int cutpurseEffect(int choice1, int choice2, int choice3,
+			  struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int j;
+  int k;
+  int currentPlayer = whoseTurn(state);
+
+  addBonusCoins(2, state);
+  for (i = 0; i < state->numPlayers; i++)
+    {
+      if (i != currentPlayer)
+	{
+	  for (j = 0; j < state->handCount[i]; j++)
+	    {
+	      if (state->hand[i][j] == copper)
+		{
+		  discardCard(j, i, state, 0);
+		  break;
+		}
+	      if (j == state->handCount[i])
+		{
+		  for (k = 0; k < state->handCount[i]; k++)
+		    {
+		      if (DEBUG)
+			printf("Player %d reveals card number %d\n", i, state->hand[i][k]);
+		    }       
+		  break;
+		}           
+	    }
+
+	}
+
+    }                               
+
+  //discard played card from hand
+  discardCard(handPos, currentPlayer, state, 0);                    
+
+  return 0;
+}
+
+static int embargoEffect(int choice1, int choice2, int choice3,
+			 struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
+
+  //+2 Coins
+  addBonusCoins(2, state);
+
+  //see if selected pile is in play
+  if ( state->supplyCount[choice1] == -1 )
+    {
+      return -1;
+    }
+
+  //add embargo token to selected supply pile
+  setEmbargoTokens(choice1, state->embargoTokens[choice1] + 1, state);
+
+  //trash card
+  discardCard(handPos, currentPlayer, state, 1);            
+  return 0;
+}
+
+static int outpostEffect(int choice1, int choice2, int choice3,
+			 struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
+
+  //set outpost flag
+  store(&state->outpostPlayed, state->outpostPlayed + 1, state);
+
+  //discard card
+  discardCard(handPos, currentPlayer, state, 0);
+  return 0;
+}
+
+static int salvagerEffect(int choice1, int choice2, int choice3,
+			  struct gameState *state, int handPos, int *bonus)
+{
+  int currentPlayer = whoseTurn(state);
+
+  //+1 buy
+  store(&state->numBuys, state->numBuys + 1, state);
+
+  if (choice1)
+    {
+      //gain coins equal to trashed card
+      addBonusCoins(getCost( handCard(choice1, state) ), state);
+      //trash card
+      discardCard(choice1, currentPlayer, state, 1);        
+    }
+
+  //discard card
+  discardCard(handPos, currentPlayer, state, 0);
+  return 0;
+}
+
+static int seaHagEffect(int choice1, int choice2, int choice3,
+			struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int currentPlayer = whoseTurn(state);
+
+  for (i = 0; i < state->numPlayers; i++){
+    if (i != currentPlayer){
+      pushCard(state->deck[i][state->deckCount[i]], discard_pile, i, state);
+      popCard(deck_pile, i, state);
+      popCard(deck_pile, i, state);
+      setPileCard(state->deckCount[i], curse, deck_pile, i, state);//Top card now a curse
+      popCard(deck_pile, i, state);
+    }
+  }
+  return 0;
+}
+
+static int treasureMapEffect(int choice1, int choice2, int choice3,
+			     struct gameState *state, int handPos, int *bonus)
+{
+  int i;
+  int index;
+  int currentPlayer = whoseTurn(state);
+
+  //search hand for another treasure_map
+  index = -1;
+  for (i = 0; i < state->handCount[currentPlayer]; i++)
+    {
+      if (state->hand[currentPlayer][i] == treasure_map && i != handPos)
+	{
+	  index = i;
+	  break;
+	}
+    }
+  if (index > -1)
+    {
+      //trash both treasure cards
+      discardCard(handPos, currentPlayer, state, 1);
+      discardCard(index, currentPlayer, state, 1);
+
+      //gain 4 Gold cards
+      for (i = 0; i < 4; i++)
+	{
+	  gainCard(gold, state, 1, currentPlayer);
+	}
+
+      //return success
+      return 1;
+    }
+
+  //no second treasure_map found in hand
+  return -1;
+}
+
+typedef int (*cardHandler)(int choice1, int choice2, int choice3,
+			   struct gameState *state, int handPos, int *bonus);
+
+//what playing each card does, NULL for cards that cannot be played
+static const cardHandler cardEffects[treasure_map+1] = {
+  [adventurer] = adventurerEffect,
+  [council_room] = councilRoomEffect,
+  [feast] = feastEffect,
+  [mine] = mineEffect,
+  [remodel] = remodelEffect,
+  [smithy] = smithyEffect,
+  [village] = villageEffect,
+  [baron] = baronEffect,
+  [great_hall] = greatHallEffect,
+  [minion] = minionEffect,
+  [steward] = stewardEffect,
+  [tribute] = tributeEffect,
+  [ambassador] = ambassadorEffect,
+  [cutpurse] = cutpurseEffect,
+  [embargo] = embargoEffect,
+  [outpost] = outpostEffect,
+  [salvager] = salvagerEffect,
+  [sea_hag] = seaHagEffect,
+  [treasure_map] = treasureMapEffect,
+};
+
+int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState *state, int handPos, int *bonus)
+{
+  if (!VALID_CARD(card) || cardEffects[card] == NULL)
+    {
+      return -1;
+    }
+  return cardEffects[card](choice1, choice2, choice3, state, handPos, bonus);
+}
+
+int discardCard(int handPos, int currentPlayer, struct gameState *state, int trashFlag)
+{
+	
+  //if card is not trashed, added to Played pile 
+  if (trashFlag < 1)
+    {
+      //add card to played pile
+      pushCard(state->hand[currentPlayer][handPos], played_pile, 0, state);
+    }
+	
+  //set played card to -1
+  setPileCard(handPos, -1, hand_pile, currentPlayer, state);
+	
+  //remove card from player's hand
+  if ( handPos == (state->handCount[currentPlayer] - 1) ) 	//last card in hand array is played
+    {
+      //reduce number of cards in hand
+      popCard(hand_pile, currentPlayer, state);
+    }
+  else if ( state->handCount[currentPlayer] == 1 ) //only one card in hand
+    {
+      //reduce number of cards in hand
+      popCard(hand_pile, currentPlayer, state);
+    }
+  else 	
+    {
+      //replace discarded card with last card in hand
+      setPileCard(handPos, state->hand[currentPlayer][ (state->handCount[currentPlayer] - 1)], hand_pile, currentPlayer, state);
+      //set last card to -1
+      setPileCard(state->handCount[currentPlayer] - 1, -1, hand_pile, currentPlayer, state);
+      //reduce number of cards in hand
+      popCard(hand_pile, currentPlayer, state);
+    }
+	
+  return 0;
+}
+
+int gainCard(int supplyPos, struct gameState *state, int toFlag, int player)
+{
+  //Note: supplyPos is enum of choosen card
+	
+  //check if supply pile is empty (0) or card is not used in game (-1)
+  if ( supplyCount(supplyPos, state) < 1 )
+    {
+      return -1;
+    }
+	
+  //added card for [whoseTurn] current player:
+  // toFlag = 0 : add to discard
+  // toFlag = 1 : add to deck
+  // toFlag = 2 : add to hand
+
+  if (toFlag == 1)
+    {
+      pushCard(supplyPos, deck_pile, player, state);
+    }
+  else if (toFlag == 2)
+    {
+      pushCard(supplyPos, hand_pile, player, state);
+    }
+  else
+    {
+      pushCard(supplyPos, discard_pile, player, state);
+    }
+	
+  //decrease number in supply pile
+  setSupplyCount(supplyPos, state->supplyCount[supplyPos] - 1, state);
+	 
+  return 0;
+}
+
+static int* pileCards(int pile, int player, struct gameState *state)
+{
+  switch( pile )
+    {
+    case deck_pile:
+      return state->deck[player];
+    case hand_pile:
+      return state->hand[player];
+    case discard_pile:
+      return state->discard[player];
+    }
+  return state->playedCards;
+}
+
+static int* pileCount(int pile, int player, struct gameState *state)
+{
+  switch( pile )
+    {
+    case deck_pile:
+      return &state->deckCount[player];
+    case hand_pile:
+      return &state->handCount[player];
+    case discard_pile:
+      return &state->discardCount[player];
+    }
+  return &state->playedCardCount;
+}
+
+static int pileSize(int pile)
+{
+  return (pile == hand_pile) ? MAX_HAND : MAX_DECK;
+}
+
+//adjust the cached counts for one live card entering (1) or leaving (-1) a pile
+static void countCard(int card, int pile, int player, int delta, struct gameState *state)
+{
+  if (pile == played_pile || card < curse || card > treasure_map)
+    {
+      return;
+    }
+  store(&state->pileCardCount[player][pile][card],
+	state->pileCardCount[player][pile][card] + delta, state);
+  store(&state->fullCardCount[player][card],
+	state->fullCardCount[player][card] + delta, state);
+  store(&state->cardTotal[player], state->cardTotal[player] + delta, state);
+  if (cardTable[card].vp != 0)
+    {
+      store(&state->victoryPoints[player],
+	    state->victoryPoints[player] + delta * cardTable[card].vp, state);
+    }
+
+  //treasure in the hand of the player whose turn it is counts as coins
+  if (pile == hand_pile && cardTable[card].coins != 0)
+    {
+      store(&state->handCoins[player],
+	    state->handCoins[player] + delta * cardTable[card].coins, state);
+      if (player == state->whoseTurn)
+	{
+	  store(&state->coins, state->coins + delta * cardTable[card].coins, state);
+	}
+    }
+}
+
+int setPileCard(int pos, int card, int pile, int player, struct gameState *state)
+{
+  int* cards = pileCards(pile, player, state);
+
+  if (pos < 0 || pos >= pileSize(pile))
+    {
+      return -1;
+    }
+
+  //only cards below the pile count are live
+  if (pos < *pileCount(pile, player, state))
+    {
+      countCard(cards[pos], pile, player, -1, state);
+      countCard(card, pile, player, 1, state);
+      state->hash ^= cardKey(cards[pos], pos, pile, player);
+      state->hash ^= cardKey(card, pos, pile, player);
+    }
+  store(&cards[pos], card, state);
+  state->dirtyPiles |= pileBit(pile, player);
+
+  return 0;
+}
+
+//n limited to 0..max
+static int clampCount(int n, int max)
+{
+  if (n > max)
+    n = max;
+  if (n < 0)
+    n = 0;
+  return n;
+}
+
+int setPileCount(int count, int pile, int player, struct gameState *state)
+{
+  int* cards = pileCards(pile, player, state);
+  int* oldCount = pileCount(pile, player, state);
+  int size = pileSize(pile);
+  int known;
+  int i;
+#ifdef LAZY_SHUFFLE
+  int live;
+#endif
+
+#ifdef LAZY_SHUFFLE
+  //cards taken off a lazily shuffled deck unseen are dealt at random too
+  if (pile == deck_pile && player >= 0 && player < MAX_PLAYERS
+      && count < *oldCount)
+    {
+      live = clampCount(*oldCount, size);
+      for (i = live - clampCount(state->deckKnown[player], live) - 1;
+	   i > 0 && i >= count; i--)
+	{
+	  pickDeckCard(i, player, state);
+	}
+    }
+#endif
+
+  //cards between the old and new count become live or dead
+  for (i = (*oldCount < 0) ? 0 : *oldCount; i < count && i < size; i++)
+    {
+      countCard(cards[i], pile, player, 1, state);
+      state->hash ^= cardKey(cards[i], i, pile, player);
+    }
+  for (i = (count < 0) ? 0 : count; i < *oldCount && i < size; i++)
+    {
+      countCard(cards[i], pile, player, -1, state);
+      state->hash ^= cardKey(cards[i], i, pile, player);
+    }
+
+  //cards put on a deck go on top in a known order, drawing uncovers the rest
+  if (pile == deck_pile && player >= 0 && player < MAX_PLAYERS)
+    {
+      known = state->deckKnown[player] + count - clampCount(*oldCount, size);
+      store(&state->deckKnown[player], clampCount(known, count), state);
+    }
+  store(oldCount, count, state);
+  state->dirtyPiles |= pileBit(pile, player);
+
+  return 0;
+}
+
+int pushCard(int card, int pile, int player, struct gameState *state)
+{
+  int count = *pileCount(pile, player, state);
+
+  if (setPileCard(count, card, pile, player, state) < 0)
+    {
+      return -1;
+    }
+  return setPileCount(count + 1, pile, player, state);
+}
+
+int popCard(int pile, int player, struct gameState *state)
+{
+  int count = *pileCount(pile, player, state);
+
+  setPileCount(count - 1, pile, player, state);
+  if (count < 1 || count > pileSize(pile))
+    {
+      return -1;
+    }
+  //card stays in the array, past the end of the pile
+  return pileCards(pile, player, state)[count - 1];
+}
 
-  //add coins for each Treasure card in player's hand
-  for (i = 0; i < state->handCount[player]; i++)
+int setSupplyCount(int card, int count, struct gameState *state)
+{
+  if (card < curse || card > treasure_map)
+    {
+      return -1;
+    }
+  state->hash ^= hashKey(HASH_SUPPLY + card, state->supplyCount[card])
+    ^ hashKey(HASH_SUPPLY + card, count);
+  if ((state->supplyCount[card] == 0) != (count == 0))
+    {
+      store(&state->emptyPiles, state->emptyPiles + (count == 0 ? 1 : -1), state);
+    }
+  storeSupply(&state->supplyCount[card], count, state);
+  return 0;
+}
+
+int setEmbargoTokens(int card, int tokens, struct gameState *state)
+{
+  if (card < curse || card > treasure_map)
+    {
+      return -1;
+    }
+  state->hash ^= hashKey(HASH_EMBARGO + card, state->embargoTokens[card])
+    ^ hashKey(HASH_EMBARGO + card, tokens);
+  storeSupply(&state->embargoTokens[card], tokens, state);
+  return 0;
+}
+
+int setTurnScalars(int phase, int numActions, int numBuys, int coins,
+		   int bonusCoins, struct gameState *state)
+{
+  store(&state->phase, phase, state);
+  store(&state->numActions, numActions, state);
+  store(&state->numBuys, numBuys, state);
+  store(&state->coins, coins, state);
+  store(&state->bonusCoins, bonusCoins, state);
+  return 0;
+}
+
+//number of live slots in a pile, clamped to the array bounds
+static int liveCount(int pile, int player, struct gameState *state)
+{
+  int count = *pileCount(pile, player, state);
+
+  if (count < 0)
+    return 0;
+  if (count > pileSize(pile))
+    return pileSize(pile);
+  return count;
+}
+
+//number of players whose piles are in use, clamped to the array bounds
+static int livePlayers(struct gameState *state)
+{
+  if (state->numPlayers < 0)
+    return 0;
+  if (state->numPlayers > MAX_PLAYERS)
+    return MAX_PLAYERS;
+  return state->numPlayers;
+}
+
+//count the cards in one player's piles into the given arrays
+static void tallyCards(int player, struct gameState *state,
+		       int pileCounts[PLAYER_PILES][treasure_map+1],
+		       int fullCounts[treasure_map+1])
+{
+  int pile;
+  int i;
+  int card;
+  int* cards;
+
+  memset(pileCounts, 0, sizeof(int) * PLAYER_PILES * (treasure_map+1));
+  memset(fullCounts, 0, sizeof(int) * (treasure_map+1));
+  for (pile = 0; pile < PLAYER_PILES; pile++)
+    {
+      cards = pileCards(pile, player, state);
+      for (i = 0; i < liveCount(pile, player, state); i++)
+	{
+	  card = cards[i];
+	  if (card >= curse && card <= treasure_map)
+	    {
+	      pileCounts[pile][card]++;
+	      fullCounts[card]++;
+	    }
+	}
+    }
+}
+
+//supply piles at 0, from scratch
+static int countEmptyPiles(struct gameState *state)
+{
+  int card;
+  int empty = 0;
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      if (state->supplyCount[card] == 0)
+	{
+	  empty++;
+	}
+    }
+  return empty;
+}
+
+//treasure value of a hand from its card counts
+static int handValue(int handCounts[treasure_map+1])
+{
+  int card;
+  int coins = 0;
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      coins += cardTable[card].coins * handCounts[card];
+    }
+  return coins;
+}
+
+//victory points of a player's cards from their counts, Gardens aside
+static int deckPoints(int fullCounts[treasure_map+1])
+{
+  int card;
+  int points = 0;
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      points += cardTable[card].vp * fullCounts[card];
+    }
+  return points;
+}
+
+//number of a player's cards from their counts
+static int deckSize(int fullCounts[treasure_map+1])
+{
+  int card;
+  int size = 0;
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      size += fullCounts[card];
+    }
+  return size;
+}
+
+//hash of the supply, embargo tokens and live pile cards, from scratch
+static unsigned long long fullHash(struct gameState *state)
+{
+  unsigned long long hash = 0;
+  int player;
+  int pile;
+  int card;
+  int i;
+  int* cards;
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      hash ^= hashKey(HASH_SUPPLY + card, state->supplyCount[card])
+	^ hashKey(HASH_EMBARGO + card, state->embargoTokens[card]);
+    }
+  for (player = 0; player < livePlayers(state); player++)
+    {
+      for (pile = 0; pile < PLAYER_PILES; pile++)
+	{
+	  cards = pileCards(pile, player, state);
+	  for (i = 0; i < liveCount(pile, player, state); i++)
+	    {
+	      hash ^= cardKey(cards[i], i, pile, player);
+	    }
+	}
+    }
+  for (i = 0; i < liveCount(played_pile, 0, state); i++)
+    {
+      hash ^= cardKey(state->playedCards[i], i, played_pile, 0);
+    }
+
+  return hash;
+}
+
+int syncGameState(struct gameState *state)
+{
+  int player;
+
+  for (player = 0; player < livePlayers(state); player++)
+    {
+      tallyCards(player, state, state->pileCardCount[player],
+		 state->fullCardCount[player]);
+      state->handCoins[player] = handValue(state->pileCardCount[player][hand_pile]);
+      state->victoryPoints[player] = deckPoints(state->fullCardCount[player]);
+      state->cardTotal[player] = deckSize(state->fullCardCount[player]);
+      state->deckKnown[player] = clampCount(state->deckKnown[player],
+					    liveCount(deck_pile, player, state));
+    }
+  state->hash = fullHash(state);
+  state->emptyPiles = countEmptyPiles(state);
+
+  return 0;
+}
+
+//key for the turn scalars
+static unsigned long long turnKey(struct gameState *state)
+{
+  return hashKey(-1, state->numPlayers)
+    ^ hashKey(-2, state->outpostPlayed)
+    ^ hashKey(-3, state->outpostTurn)
+    ^ hashKey(-4, state->whoseTurn)
+    ^ hashKey(-5, state->phase)
+    ^ hashKey(-6, state->numActions)
+    ^ hashKey(-7, state->coins)
+    ^ hashKey(-8, state->numBuys);
+}
+
+unsigned long long stateHash(struct gameState *state)
+{
+  //turn scalars change on nearly every call, so they are mixed in here
+  return state->hash ^ turnKey(state);
+}
+
+unsigned long long canonicalKey(struct gameState *state)
+{
+  unsigned long long key = turnKey(state);
+  int counts[treasure_map+1];
+  int player;
+  int pile;
+  int card;
+  int count;
+  int i;
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      key ^= hashKey(HASH_SUPPLY + card, state->supplyCount[card])
+	^ hashKey(HASH_EMBARGO + card, state->embargoTokens[card]);
+    }
+
+  for (player = 0; player < livePlayers(state); player++)
+    {
+      //known deck cards keep their order, counted down from the top
+      count = liveCount(deck_pile, player, state);
+      memcpy(counts, state->pileCardCount[player][deck_pile], sizeof(counts));
+      for (i = count - state->deckKnown[player]; i < count; i++)
+	{
+	  key ^= hashKey(HASH_KNOWN + player * MAX_DECK + count - 1 - i,
+			 state->deck[player][i]);
+	  if (state->deck[player][i] >= curse && state->deck[player][i] <= treasure_map)
+	    counts[state->deck[player][i]]--;
+	}
+
+      //every other zone is a multiset
+      for (pile = 0; pile < PLAYER_PILES; pile++)
+	{
+	  for (card = curse; card <= treasure_map; card++)
+	    {
+	      key ^= hashKey(HASH_ZONES + (player * PLAYER_PILES + pile) * (treasure_map+1) + card,
+			     (pile == deck_pile) ? counts[card]
+			     : state->pileCardCount[player][pile][card]);
+	    }
+	}
+    }
+
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < liveCount(played_pile, 0, state); i++)
+    {
+      if (state->playedCards[i] >= curse && state->playedCards[i] <= treasure_map)
+	counts[state->playedCards[i]]++;
+    }
+  for (card = curse; card <= treasure_map; card++)
+    {
+      key ^= hashKey(HASH_ZONES + MAX_PLAYERS * PLAYER_PILES * (treasure_map+1) + card,
+		     counts[card]);
+    }
+
+  return key;
+}
+
+//sort the live slots [from, to) of a pile, writing only the cards that move
+static void sortPile(int from, int to, int pile, int player, struct gameState *state)
+{
+  int sorted[MAX_DECK];
+  int* cards = pileCards(pile, player, state);
+  int i;
+
+  if (to <= from)
+    return;
+  memcpy(sorted, cards + from, sizeof(int) * (to - from));
+  qsort((void*)sorted, to - from, sizeof(int), compare);
+  for (i = from; i < to; i++)
+    {
+      if (cards[i] != sorted[i - from])
+	setPileCard(i, sorted[i - from], pile, player, state);
+    }
+}
+
+int canonicalizeState(struct gameState *state)
+{
+  int player;
+  int count;
+
+  for (player = 0; player < livePlayers(state); player++)
+    {
+      count = liveCount(deck_pile, player, state);
+      sortPile(0, count - state->deckKnown[player], deck_pile, player, state);
+      sortPile(0, liveCount(hand_pile, player, state), hand_pile, player, state);
+      sortPile(0, liveCount(discard_pile, player, state), discard_pile, player, state);
+    }
+  sortPile(0, liveCount(played_pile, 0, state), played_pile, 0, state);
+
+  return 0;
+}
+
+int checkGameState(struct gameState *state)
+{
+  int pileCounts[PLAYER_PILES][treasure_map+1];
+  int fullCounts[treasure_map+1];
+  int player;
+
+  for (player = 0; player < livePlayers(state); player++)
+    {
+      tallyCards(player, state, pileCounts, fullCounts);
+      if (memcmp(pileCounts, state->pileCardCount[player], sizeof(pileCounts)) != 0
+	  || memcmp(fullCounts, state->fullCardCount[player], sizeof(fullCounts)) != 0
+	  || state->handCoins[player] != handValue(pileCounts[hand_pile])
+	  || state->victoryPoints[player] != deckPoints(fullCounts)
+	  || state->cardTotal[player] != deckSize(fullCounts)
+	  || state->deckKnown[player] != clampCount(state->deckKnown[player],
+						    liveCount(deck_pile, player, state)))
+	{
+	  if (DEBUG)
+	    printf("Card counts for player %d do not match piles\n", player);
+	  return -1;
+	}
+    }
+  if (fullHash(state) != state->hash)
+    {
+      if (DEBUG)
+	printf("State hash does not match piles and supply\n");
+      return -1;
+    }
+  if (countEmptyPiles(state) != state->emptyPiles)
+    {
+      if (DEBUG)
+	printf("Empty pile count does not match supply\n");
+      return -1;
+    }
+
+  return 0;
+}
+
+struct gameSnapshot* newSnapshot()
+{
+  return calloc(1, sizeof(struct gameSnapshot));
+}
+
+int freeSnapshot(struct gameSnapshot *snap)
+{
+  if (snap == NULL)
+    {
+      return -1;
+    }
+  free(snap->cards);
+  free(snap);
+  return 0;
+}
+
+//pile and player of the pile at a PILE_BIT position
+static void slotPile(int slot, int *pile, int *player)
+{
+  if (slot == MAX_PLAYERS * PLAYER_PILES)
+    {
+      *pile = played_pile;
+      *player = 0;
+      return;
+    }
+  *pile = slot % PLAYER_PILES;
+  *player = slot / PLAYER_PILES;
+}
+
+//snapshots cover the played pile and the piles of players in the game
+static int slotInGame(int slot, struct gameState *state)
+{
+  return slot == MAX_PLAYERS * PLAYER_PILES
+    || slot / PLAYER_PILES < livePlayers(state);
+}
+
+int takeSnapshot(struct gameState *state, struct gameSnapshot *snap)
+{
+  int slot;
+  int pile;
+  int player;
+  int live;
+  int size = 0;
+  int* cards;
+
+  for (slot = 0; slot < PILE_SLOTS; slot++)
+    {
+      slotPile(slot, &pile, &player);
+      if (slotInGame(slot, state))
+	size += liveCount(pile, player, state);
+    }
+  if (size > snap->capacity)
+    {
+      cards = realloc(snap->cards, sizeof(int) * size);
+      if (cards == NULL)
+	{
+	  return -1;
+	}
+      snap->cards = cards;
+      snap->capacity = size;
+    }
+
+  snap->numPlayers = state->numPlayers;
+  memcpy(snap->supplyCount, state->supplyCount, sizeof(state->supplyCount));
+  memcpy(snap->embargoTokens, state->embargoTokens, sizeof(state->embargoTokens));
+  snap->outpostPlayed = state->outpostPlayed;
+  snap->outpostTurn = state->outpostTurn;
+  snap->whoseTurn = state->whoseTurn;
+  snap->phase = state->phase;
+  snap->numActions = state->numActions;
+  snap->coins = state->coins;
+  snap->numBuys = state->numBuys;
+  snap->hash = state->hash;
+  memcpy(snap->deckKnown, state->deckKnown, sizeof(state->deckKnown));
+  memcpy(snap->shuffles, state->shuffles, sizeof(state->shuffles));
+  snap->bonusCoins = state->bonusCoins;
+
+  size = 0;
+  for (slot = 0; slot < PILE_SLOTS; slot++)
+    {
+      snap->pileCount[slot] = 0;
+      snap->pileStart[slot] = size;
+      if (!slotInGame(slot, state))
+	{
+	  continue;
+	}
+      slotPile(slot, &pile, &player);
+      live = liveCount(pile, player, state);
+      snap->pileCount[slot] = *pileCount(pile, player, state);
+      memcpy(snap->cards + size, pileCards(pile, player, state), sizeof(int) * live);
+      size += live;
+    }
+
+  state->dirtyPiles = 0;
+  return 0;
+}
+
+int restoreSnapshot(struct gameSnapshot *snap, struct gameState *state)
+{
+  int slot;
+  int pile;
+  int player;
+  int live;
+  int retally = 0;
+
+  state->numPlayers = snap->numPlayers;
+  memcpy(state->supplyCount, snap->supplyCount, sizeof(state->supplyCount));
+  state->emptyPiles = countEmptyPiles(state);
+  memcpy(state->embargoTokens, snap->embargoTokens, sizeof(state->embargoTokens));
+  state->outpostPlayed = snap->outpostPlayed;
+  state->outpostTurn = snap->outpostTurn;
+  state->whoseTurn = snap->whoseTurn;
+  state->phase = snap->phase;
+  state->numActions = snap->numActions;
+  state->coins = snap->coins;
+  state->numBuys = snap->numBuys;
+  state->hash = snap->hash;
+  memcpy(state->deckKnown, snap->deckKnown, sizeof(state->deckKnown));
+  memcpy(state->shuffles, snap->shuffles, sizeof(state->shuffles));
+  state->bonusCoins = snap->bonusCoins;
+
+  //write the arrays directly, then recount each player touched once
+  for (slot = 0; slot < PILE_SLOTS; slot++)
+    {
+      if (!(state->dirtyPiles & (1u << slot)) || !slotInGame(slot, state))
+	{
+	  continue;
+	}
+      slotPile(slot, &pile, &player);
+      *pileCount(pile, player, state) = snap->pileCount[slot];
+      live = liveCount(pile, player, state);
+      memcpy(pileCards(pile, player, state), snap->cards + snap->pileStart[slot],
+	     sizeof(int) * live);
+      if (pile != played_pile)
+	{
+	  retally |= 1 << player;
+	}
+    }
+  for (player = 0; player < MAX_PLAYERS; player++)
     {
-      if (state->hand[player][i] == copper)
+      if (retally & (1 << player))
 	{
-	  state->coins += 1;
+	  tallyCards(player, state, state->pileCardCount[player],
+		     state->fullCardCount[player]);
+	  state->handCoins[player] = handValue(state->pileCardCount[player][hand_pile]);
+	  state->victoryPoints[player] = deckPoints(state->fullCardCount[player]);
+	  state->cardTotal[player] = deckSize(state->fullCardCount[player]);
 	}
-      else if (state->hand[player][i] == silver)
+    }
+
+  state->dirtyPiles = 0;
+  return 0;
+}
+
+int diffSnapshot(struct gameSnapshot *snap, struct gameState *state,
+		 unsigned int *changedPiles)
+{
+  int fields = 0;
+  int slot;
+  int pile;
+  int player;
+
+  if (state->numPlayers != snap->numPlayers)
+    fields |= field_numPlayers;
+  if (memcmp(state->supplyCount, snap->supplyCount, sizeof(state->supplyCount)) != 0)
+    fields |= field_supplyCount;
+  if (memcmp(state->embargoTokens, snap->embargoTokens, sizeof(state->embargoTokens)) != 0)
+    fields |= field_embargoTokens;
+  if (state->outpostPlayed != snap->outpostPlayed)
+    fields |= field_outpostPlayed;
+  if (state->outpostTurn != snap->outpostTurn)
+    fields |= field_outpostTurn;
+  if (state->whoseTurn != snap->whoseTurn)
+    fields |= field_whoseTurn;
+  if (state->phase != snap->phase)
+    fields |= field_phase;
+  if (state->numActions != snap->numActions)
+    fields |= field_numActions;
+  if (state->coins != snap->coins || state->bonusCoins != snap->bonusCoins)
+    fields |= field_coins;
+  if (state->numBuys != snap->numBuys)
+    fields |= field_numBuys;
+  if (memcmp(state->deckKnown, snap->deckKnown, sizeof(state->deckKnown)) != 0)
+    fields |= field_deckKnown;
+  if (memcmp(state->shuffles, snap->shuffles, sizeof(state->shuffles)) != 0)
+    fields |= field_shuffles;
+
+  *changedPiles = 0;
+  for (slot = 0; slot < PILE_SLOTS; slot++)
+    {
+      if (!(state->dirtyPiles & (1u << slot)) || !slotInGame(slot, state))
 	{
-	  state->coins += 2;
+	  continue;
 	}
-      else if (state->hand[player][i] == gold)
+      slotPile(slot, &pile, &player);
+      if (*pileCount(pile, player, state) != snap->pileCount[slot]
+	  || memcmp(pileCards(pile, player, state), snap->cards + snap->pileStart[slot],
+		    sizeof(int) * liveCount(pile, player, state)) != 0)
 	{
-	  state->coins += 3;
-	}	
-    }	
+	  *changedPiles |= 1u << slot;
+	}
+    }
+
+  return fields;
+}
+
+struct moveJournal* newJournal()
+{
+  return calloc(1, sizeof(struct moveJournal));
+}
+
+int freeJournal(struct moveJournal *journal)
+{
+  if (journal == NULL)
+    {
+      return -1;
+    }
+  free(journal->entries);
+  free(journal->marks);
+  free(journal);
+  return 0;
+}
+
+int markJournal(struct gameState *state)
+{
+  struct moveJournal* journal = state->journal;
+  struct journalMark* mark;
+
+  if (journal == NULL
+      || (journal->markCount == journal->markCapacity
+	  && growArray((void**)&journal->marks, &journal->markCapacity,
+		       sizeof(struct journalMark)) < 0))
+    {
+      return -1;
+    }
+  mark = &journal->marks[journal->markCount];
+  mark->entries = journal->count;
+  GetPositionCtx(state->rng, &mark->rng);
+  mark->hash = state->hash;
+  return journal->markCount++;
+}
+
+int undoJournal(int mark, struct gameState *state)
+{
+  struct moveJournal* journal = state->journal;
+  struct journalEntry* entry;
+
+  if (journal == NULL || mark < 0 || mark >= journal->markCount
+      || mark < journal->lostMarks)
+    {
+      return -1;
+    }
+
+  //newest write first, so each field ends at its value as of the mark
+  while (journal->count > journal->marks[mark].entries)
+    {
+      entry = &journal->entries[--journal->count];
+      if (entry->width == sizeof(int))
+	*(int*)entry->field = entry->value;
+      else
+	*(supply_t*)entry->field = entry->value;
+    }
+  SetPositionCtx(state->rng, &journal->marks[mark].rng);
+  state->hash = journal->marks[mark].hash;
+  journal->markCount = mark + 1;
+
+  return 0;
+}
+
+int clearJournal(struct moveJournal *journal)
+{
+  if (journal == NULL)
+    {
+      return -1;
+    }
+  journal->count = 0;
+  journal->markCount = 0;
+  journal->lostMarks = 0;
+  return 0;
+}
+
+int updateCoins(int player, struct gameState *state, int bonus)
+{
 
-  //add bonus
-  state->coins += bonus;
+  //treasure in player's hand, kept up to date as cards come and go, plus the bonus
+  store(&state->coins, state->handCoins[player] + bonus, state);
+  store(&state->bonusCoins, bonus, state);
 
   return 0;
 }
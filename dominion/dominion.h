@@ -7,9 +7,26 @@
 #define MAX_DECK 500
 
 #define MAX_PLAYERS 4
+#define SUPPLY_PLAYERS 6 /* largest game cardTable has supply sizes for */
 
 #define DEBUG 0
 
+/* shuffle() sorts the deck and then picks cards one at a time, which is
+   O(n^2) but gives the sequence every existing seed and test expects.
+   Simulation builds (-DSIMULATION) use an in-place Fisher-Yates with
+   unbiased RandomInt() draws instead;
+   define LEGACY_SHUFFLE as well to keep the old sequence there */
+#ifndef SIMULATION
+#define LEGACY_SHUFFLE
+#endif
+
+/* With -DLAZY_SHUFFLE, shuffle() only forgets the deck order: the deck
+   below its deckKnown top cards is an unordered pool, and each card taken
+   off it is picked at random from the pool as it is drawn, revealed or
+   discarded (a partial Fisher-Yates).  The cards come off in the same
+   distribution as after a full shuffle, but only those actually used are
+   paid for.  Overrides LEGACY_SHUFFLE in shuffle() */
+
 /* http://dominion.diehrstraits.com has card texts */
 /* http://dominion.isotropic.org has other stuff */
 
@@ -52,10 +69,108 @@ enum CARD
    treasure_map
   };
 
+/* Card types, or'd together in cardInfo.types */
+#define TREASURE_CARD 1
+#define VICTORY_CARD  2
+#define ACTION_CARD   4
+#define ATTACK_CARD   8
+#define CURSE_CARD    16
+
+#define VALID_CARD(card) ((card) >= curse && (card) <= treasure_map)
+
+/* What never changes about a card during a game */
+struct cardInfo {
+  const char* name;
+  int cost;
+  int types;                   /* TREASURE_CARD | VICTORY_CARD | ... */
+  int coins;                   /* value as a treasure */
+  int vp;                      /* victory points; gardens scores apart */
+  int supply[SUPPLY_PLAYERS + 1]; /* starting supply by number of players */
+};
+
+/* Every card, indexed by enum CARD.  Costs, names, treasure values,
+   victory points and supply sizes are all read from here, so a new card
+   is added in this one place */
+extern const struct cardInfo cardTable[treasure_map+1];
+
+/* Piles a card can sit in.  Hand, deck and discard belong to one player,
+   the played pile is shared by everyone. */
+enum PILE
+  {deck_pile = 0,
+   hand_pile,
+   discard_pile,
+   played_pile
+  };
+
+#define PLAYER_PILES 3 /* deck, hand and discard */
+#define PILE_SLOTS (MAX_PLAYERS * PLAYER_PILES + 1) /* every pile in a game */
+
+/* Bit standing for one pile in a set of piles */
+#define PILE_BIT(pile, player) \
+  (1u << ((pile) == played_pile ? MAX_PLAYERS * PLAYER_PILES : (player) * PLAYER_PILES + (pile)))
+
+struct moveJournal;
+struct rngState;
+
+/* Cached fields at the end of either layout of struct gameState, kept in
+   step with the pile arrays by every engine function; see
+   syncGameState() */
+#define GAME_STATE_CACHED_FIELDS \
+  int pileCardCount[MAX_PLAYERS][PLAYER_PILES][treasure_map+1]; /* [player][enum PILE][card] */ \
+  int fullCardCount[MAX_PLAYERS][treasure_map+1]; /* deck + hand + discard */ \
+  unsigned long long hash; /* supply, embargo and live pile cards, see stateHash() */ \
+  int deckKnown[MAX_PLAYERS]; /* top deck cards whose order is known, 0 after a shuffle */ \
+  int shuffles[MAX_PLAYERS]; /* times each deck was shuffled */ \
+  int crnSeed; /* game seed keying every shuffle, 0 unless initializeGameCrn() */ \
+  int handCoins[MAX_PLAYERS]; /* treasure value of each hand */ \
+  int bonusCoins; /* coins from actions this turn, already in coins */ \
+  int emptyPiles; /* supply piles at 0, kept by setSupplyCount() */ \
+  int victoryPoints[MAX_PLAYERS]; /* VP of each player's cards, Gardens aside */ \
+  int cardTotal[MAX_PLAYERS]; /* cards in deck + hand + discard */ \
+  unsigned int dirtyPiles; /* PILE_BIT of each pile written since takeSnapshot() */ \
+  struct moveJournal* journal; /* undo log, NULL when not recording */ \
+  struct rngState* rng; /* random number streams, NULL for the global ones in rngs.c */
+
+#ifdef SPLIT_LAYOUT
+
+/* Hot/cold layout: the per-turn fields share the first cache line, supply
+   and embargo counts are packed one byte each into the second, and the
+   pile arrays follow on their own lines */
+
+#define CACHE_LINE 64
+
+typedef signed char supply_t; /* -1 for cards not in the game, at most 60 */
+
 struct gameState {
+  int whoseTurn;
+  int phase;
+  int numActions; /* Starts at 1 each turn */
+  int coins; /* Use as you see fit! */
+  int numBuys; /* Starts at 1 each turn */
+  int outpostPlayed;
+  int outpostTurn;
+  int playedCardCount;
   int numPlayers; //number of players
-  int supplyCount[treasure_map+1];  //this is the amount of a specific type of card given a specific number.
-  int embargoTokens[treasure_map+1];
+  int handCount[MAX_PLAYERS];
+  supply_t supplyCount[treasure_map+1] __attribute__((aligned(CACHE_LINE)));
+  supply_t embargoTokens[treasure_map+1];
+  int deckCount[MAX_PLAYERS];
+  int discardCount[MAX_PLAYERS];
+  int hand[MAX_PLAYERS][MAX_HAND] __attribute__((aligned(CACHE_LINE)));
+  int deck[MAX_PLAYERS][MAX_DECK];
+  int discard[MAX_PLAYERS][MAX_DECK];
+  int playedCards[MAX_DECK];
+  GAME_STATE_CACHED_FIELDS
+} __attribute__((aligned(CACHE_LINE)));
+
+#else
+
+typedef int supply_t;
+
+struct gameState {
+  int numPlayers; //number of players
+  supply_t supplyCount[treasure_map+1];  //this is the amount of a specific type of card given a specific number.
+  supply_t embargoTokens[treasure_map+1];
   int outpostPlayed;
   int outpostTurn;
   int whoseTurn;
@@ -71,15 +186,100 @@ struct gameState {
   int discardCount[MAX_PLAYERS];
   int playedCards[MAX_DECK];
   int playedCardCount;
+  GAME_STATE_CACHED_FIELDS
 };
 
+#endif
+
+/* Saved copy of a game state, see takeSnapshot() */
+struct gameSnapshot {
+  int numPlayers;
+  supply_t supplyCount[treasure_map+1];
+  supply_t embargoTokens[treasure_map+1];
+  int outpostPlayed;
+  int outpostTurn;
+  int whoseTurn;
+  int phase;
+  int numActions;
+  int coins;
+  int numBuys;
+  unsigned long long hash;
+  int deckKnown[MAX_PLAYERS];
+  int shuffles[MAX_PLAYERS];
+  int bonusCoins;
+  int pileCount[PILE_SLOTS];   /* pile counts, in PILE_BIT order */
+  int pileStart[PILE_SLOTS];   /* where each pile's live cards sit in cards */
+  int* cards;                  /* live cards of every pile */
+  int capacity;
+};
+
+/* Fields reported by diffSnapshot() */
+enum FIELD
+  {field_numPlayers = 1 << 0,
+   field_supplyCount = 1 << 1,
+   field_embargoTokens = 1 << 2,
+   field_outpostPlayed = 1 << 3,
+   field_outpostTurn = 1 << 4,
+   field_whoseTurn = 1 << 5,
+   field_phase = 1 << 6,
+   field_numActions = 1 << 7,
+   field_coins = 1 << 8,
+   field_numBuys = 1 << 9,
+   field_deckKnown = 1 << 10,
+   field_shuffles = 1 << 11
+  };
+
 /* All functions return -1 on failure, and DO NOT CHANGE GAME STATE;
    unless specified for other return, return 0 on success */
 
+struct gamePool;
+/* Pool of preallocated game states and kingdom card arrays.  Functions
+   taking a pool use a process-wide default pool when it is NULL.  A
+   state or array belongs to the pool it was acquired from: release it
+   only to that pool, at most once, and not after freeGamePool.  Never
+   release a state or array that did not come from acquireGame or
+   acquireKingdomCards (newGame and kingdomCards use the default pool).
+   DEBUG builds check that a released pointer is a slot of the pool and
+   return -1 if not; other builds trust the caller */
+
+struct gamePool* newGamePool(int blockSize);
+/* Create an empty pool that grows blockSize states at a time.  Returns
+   NULL if out of memory */
+
+int freeGamePool(struct gamePool *pool);
+/* Free every block of the pool at once, including states and kingdom
+   arrays still acquired from it */
+
+struct gameState* acquireGame(struct gamePool *pool);
+/* Zero-filled state from the pool, or NULL if out of memory */
+
+int releaseGame(struct gamePool *pool, struct gameState *state);
+/* Return a state to the pool it was acquired from */
+
+int* acquireKingdomCards(struct gamePool *pool);
+/* Array of 10 ints from the pool, or NULL if out of memory */
+
+int releaseKingdomCards(struct gamePool *pool, int *k);
+/* Return an array to the pool it was acquired from */
+
+int setPoolTemplate(struct gamePool *pool, int numPlayers, int kingdomCards[10],
+		    int randomSeed);
+/* Run initializeGame once into the pool's template state */
+
+int resetGame(struct gamePool *pool, struct gameState *state);
+/* Copy the pool's template into state and restore the random number
+   stream to where initializeGame left it, so state ends up as a fresh
+   initializeGame with the template's arguments would leave it.  The
+   template and so state use the global random number streams.  Only the
+   live part of each pile is copied.  -1 if setPoolTemplate has not been
+   called, or if the global streams have switched generator since */
+
 struct gameState* newGame();
+/* acquireGame from the default pool */
 
 int* kingdomCards(int k1, int k2, int k3, int k4, int k5, int k6, int k7,
 		  int k8, int k9, int k10);
+/* Kingdom array from the default pool */
 
 int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
 		   struct gameState *state);
@@ -89,9 +289,43 @@ int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
 
 Cards not in game should initialize supply position to -1 */
 
+int initializeGameWithRng(int numPlayers, int kingdomCards[10], int randomSeed,
+			  struct rngState *rng, struct gameState *state);
+/* initializeGame drawing from rng instead of the global streams.  rng
+   stays attached to state, and shuffles draw from it for the rest of the
+   game; initializeGame attaches NULL */
+
+int initializeGameCrn(int numPlayers, int kingdomCards[10], int randomSeed,
+		      struct rngState *rng, struct gameState *state);
+/* initializeGameWithRng in common random numbers mode: every shuffle of
+   player p draws from a stream of its own, reseeded from (randomSeed, p,
+   how many times p shuffled before).  Games on the same seed then deal
+   the same shuffles to each player however differently they are played,
+   so A/B runs of two strategies differ by the strategies rather than the
+   luck of the draw.  Draws other than shuffles still come from stream 1
+   of rng */
+
+struct openingCache;
+/* Shuffled starting decks of games already set up, keyed by random seed
+   and number of players */
+
+struct openingCache* newOpeningCache();
+/* Empty cache, or NULL if out of memory */
+
+int freeOpeningCache(struct openingCache *cache);
+
+int initializeGameCached(struct openingCache *cache, int numPlayers,
+			 int kingdomCards[10], int randomSeed,
+			 struct rngState *rng, struct gameState *state);
+/* initializeGameWithRng, copying the starting decks from cache instead of
+   shuffling them when the same seed and number of players were set up
+   before on the same generator, and adding them to cache otherwise.
+   Either way state and rng end up exactly as initializeGameWithRng would
+   leave them */
+
 int shuffle(int player, struct gameState *state);
 /* Assumes all cards are now in deck array (or hand/played):  discard is
- empty */
+ empty.  O(n) unless LEGACY_SHUFFLE, O(1) with LAZY_SHUFFLE, see above */
 
 int playCard(int handPos, int choice1, int choice2, int choice3,
 	     struct gameState *state);
@@ -128,4 +362,75 @@ int getWinners(int players[MAX_PLAYERS], struct gameState *state);
 /* Set array position of each player who won (remember ties!) to
    1, others to 0 */
 
+int syncGameState(struct gameState *state);
+/* Recompute the cached card counts from the pile arrays.  Call after
+   writing hand/deck/discard arrays directly instead of through the
+   engine */
+
+int checkGameState(struct gameState *state);
+/* Debug consistency check: returns 0 if the cached card counts and hash
+   match the pile arrays and supply, -1 otherwise.  Does not change game
+   state */
+
+unsigned long long stateHash(struct gameState *state);
+/* 64-bit Zobrist hash of the game position: supply, embargo tokens, the
+   live cards of every pile in order and the turn fields.  Kept up to date
+   by the engine functions at O(1) per card moved; equal positions hash
+   equal regardless of the dead slots past the end of each pile */
+
+unsigned long long canonicalKey(struct gameState *state);
+/* Hash that ignores card order wherever it is hidden or irrelevant:
+   hands, discard piles, the played pile and the part of each deck below
+   its deckKnown top cards count as multisets of cards.  Positions that
+   differ only in those orders get the same key */
+
+int canonicalizeState(struct gameState *state);
+/* Sort the hands, discard piles, played pile and the unknown part of
+   each deck, so equivalent positions become equal states.  Hand
+   positions change */
+
+struct gameSnapshot* newSnapshot();
+/* Empty snapshot, or NULL if out of memory */
+
+int freeSnapshot(struct gameSnapshot *snap);
+
+int takeSnapshot(struct gameState *state, struct gameSnapshot *snap);
+/* Save the scalars and the live part of the played pile and of each
+   player's piles into snap, then clear state->dirtyPiles so the engine
+   functions record from here on which piles they write.  -1 if out of
+   memory */
+
+int restoreSnapshot(struct gameSnapshot *snap, struct gameState *state);
+/* Put state back the way it was at takeSnapshot, copying back the scalars
+   and only the piles marked in state->dirtyPiles.  Piles written directly
+   instead of through the engine must be added to dirtyPiles by the
+   caller.  Slots past the end of a pile are not restored */
+
+int diffSnapshot(struct gameSnapshot *snap, struct gameState *state,
+		 unsigned int *changedPiles);
+/* Returns the enum FIELD bits of every scalar field that differs from
+   snap and sets changedPiles to the PILE_BIT of every dirty pile whose
+   count or live cards differ */
+
+struct moveJournal* newJournal();
+/* Empty undo log, or NULL if out of memory.  Attach it by setting
+   state->journal; from then on every write the engine functions make to
+   the state is recorded with its prior value.  initializeGame and
+   resetGame detach any journal */
+
+int freeJournal(struct moveJournal *journal);
+
+int markJournal(struct gameState *state);
+/* Returns a mark for the current position, including the position of
+   the current stream of state->rng, or -1 if no journal is attached */
+
+int undoJournal(int mark, struct gameState *state);
+/* Roll state and its random number stream back to mark, undoing every
+   recorded write since then in reverse order.  mark stays valid, marks
+   taken after it are dropped.  -1 if mark is not valid or the journal
+   ran out of memory since it was taken */
+
+int clearJournal(struct moveJournal *journal);
+/* Drop all marks and recorded writes, keeping the current state */
+
 #endif
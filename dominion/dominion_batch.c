@@ -0,0 +1,265 @@
+#include "dominion_batch.h"
+#include "dominion_helpers.h"
+#include <stdlib.h>
+#include <string.h>
+
+//number of [lane] arrays carved out of the storage block
+#define BATCH_ROWS (7 + 4 * (treasure_map+1) + MAX_PLAYERS * (treasure_map+1))
+
+struct gameBatch* newGameBatch(int lanes) {
+  struct gameBatch* batch;
+  int* row;
+  int card;
+  int player;
+
+  if (lanes < 1)
+    {
+      return NULL;
+    }
+  batch = malloc(sizeof(struct gameBatch));
+  if (batch == NULL)
+    {
+      return NULL;
+    }
+  batch->storage = calloc((size_t)BATCH_ROWS * lanes, sizeof(int));
+  if (batch->storage == NULL)
+    {
+      free(batch);
+      return NULL;
+    }
+
+  batch->lanes = lanes;
+  row = batch->storage;
+  batch->numPlayers = row; row += lanes;
+  batch->whoseTurn = row; row += lanes;
+  batch->phase = row; row += lanes;
+  batch->numActions = row; row += lanes;
+  batch->coins = row; row += lanes;
+  batch->bonusCoins = row; row += lanes;
+  batch->numBuys = row; row += lanes;
+  for (card = curse; card <= treasure_map; card++)
+    {
+      batch->supplyCount[card] = row; row += lanes;
+      batch->embargoTokens[card] = row; row += lanes;
+      batch->handCardCount[card] = row; row += lanes;
+      batch->gainedCount[card] = row; row += lanes;
+      for (player = 0; player < MAX_PLAYERS; player++)
+	{
+	  batch->fullCardCount[player][card] = row; row += lanes;
+	}
+    }
+
+  return batch;
+}
+
+int freeGameBatch(struct gameBatch *batch) {
+  if (batch == NULL)
+    {
+      return -1;
+    }
+  free(batch->storage);
+  free(batch);
+  return 0;
+}
+
+int loadBatchLane(struct gameBatch *batch, int lane, struct gameState *state) {
+  int card;
+  int player;
+  int current = state->whoseTurn;
+
+  if (lane < 0 || lane >= batch->lanes)
+    {
+      return -1;
+    }
+
+  batch->numPlayers[lane] = state->numPlayers;
+  batch->whoseTurn[lane] = current;
+  batch->phase[lane] = state->phase;
+  batch->numActions[lane] = state->numActions;
+  batch->coins[lane] = state->coins;
+  batch->bonusCoins[lane] = state->bonusCoins;
+  batch->numBuys[lane] = state->numBuys;
+  for (card = curse; card <= treasure_map; card++)
+    {
+      batch->supplyCount[card][lane] = state->supplyCount[card];
+      batch->embargoTokens[card][lane] = state->embargoTokens[card];
+      batch->handCardCount[card][lane] = state->pileCardCount[current][hand_pile][card];
+      batch->gainedCount[card][lane] = 0;
+      for (player = 0; player < MAX_PLAYERS; player++)
+	{
+	  batch->fullCardCount[player][card][lane] =
+	    (player < state->numPlayers) ? state->fullCardCount[player][card] : 0;
+	}
+    }
+
+  return 0;
+}
+
+int storeBatchLane(struct gameBatch *batch, int lane, struct gameState *state) {
+  int card;
+  int i;
+
+  if (lane < 0 || lane >= batch->lanes)
+    {
+      return -1;
+    }
+
+  //through the engine setters, so a journal attached to state sees them
+  setTurnScalars(batch->phase[lane], batch->numActions[lane], batch->numBuys[lane],
+		 batch->coins[lane], batch->bonusCoins[lane], state);
+  for (card = curse; card <= treasure_map; card++)
+    {
+      setSupplyCount(card, batch->supplyCount[card][lane], state);
+      setEmbargoTokens(card, batch->embargoTokens[card][lane], state);
+      for (i = 0; i < batch->gainedCount[card][lane]; i++)
+	{
+	  pushCard(card, discard_pile, batch->whoseTurn[lane], state);
+	}
+      batch->gainedCount[card][lane] = 0;
+    }
+
+  return 0;
+}
+
+void batchUpdateCoins(struct gameBatch *batch, int *bonus) {
+  int lane;
+  int lanes = batch->lanes;
+  int card;
+  int* coins = batch->coins;
+  int* bonusCoins = batch->bonusCoins;
+  int* counts;
+
+  for (lane = 0; lane < lanes; lane++)
+    {
+      bonusCoins[lane] = bonus ? bonus[lane] : 0;
+      coins[lane] = bonusCoins[lane];
+    }
+  for (card = curse; card <= treasure_map; card++)
+    {
+      if (cardTable[card].coins == 0)
+	{
+	  continue;
+	}
+      counts = batch->handCardCount[card];
+      for (lane = 0; lane < lanes; lane++)
+	{
+	  coins[lane] += cardTable[card].coins * counts[lane];
+	}
+    }
+}
+
+void batchIsGameOver(struct gameBatch *batch, int *gameOver) {
+  int lane;
+  int card;
+  int lanes = batch->lanes;
+  int* supply;
+
+  //gameOver counts empty piles first
+  for (lane = 0; lane < lanes; lane++)
+    {
+      gameOver[lane] = 0;
+    }
+  for (card = curse; card <= treasure_map; card++)
+    {
+      supply = batch->supplyCount[card];
+      for (lane = 0; lane < lanes; lane++)
+	{
+	  gameOver[lane] += (supply[lane] == 0);
+	}
+    }
+
+  supply = batch->supplyCount[province];
+  for (lane = 0; lane < lanes; lane++)
+    {
+      gameOver[lane] = (gameOver[lane] >= 3) | (supply[lane] == 0);
+    }
+}
+
+void batchScoreFor(struct gameBatch *batch, int player, int *score) {
+  int lane;
+  int card;
+  int lanes = batch->lanes;
+  int* counts;
+  int* gardenCards = batch->fullCardCount[player][gardens];
+
+  //score holds the total card count until the gardens pass
+  for (lane = 0; lane < lanes; lane++)
+    {
+      score[lane] = 0;
+    }
+  for (card = curse; card <= treasure_map; card++)
+    {
+      counts = batch->fullCardCount[player][card];
+      for (lane = 0; lane < lanes; lane++)
+	{
+	  score[lane] += counts[lane];
+	}
+    }
+  for (lane = 0; lane < lanes; lane++)
+    {
+      score[lane] = gardenCards[lane] * (score[lane] / 10);
+    }
+
+  for (card = curse; card <= treasure_map; card++)
+    {
+      if (cardTable[card].vp == 0)
+	{
+	  continue;
+	}
+      counts = batch->fullCardCount[player][card];
+      for (lane = 0; lane < lanes; lane++)
+	{
+	  score[lane] += cardTable[card].vp * counts[lane];
+	}
+    }
+}
+
+void batchBuyCard(struct gameBatch *batch, int *restrict supplyPos, int *restrict result) {
+  int lane;
+  int card;
+  int player;
+  int cost;
+  int bought;
+  int lanes = batch->lanes;
+  //lane rows never overlap
+  int* restrict coins = batch->coins;
+  int* restrict numBuys = batch->numBuys;
+  int* restrict phase = batch->phase;
+  int* restrict supply;
+  int* restrict gained;
+  int* full;
+
+  for (lane = 0; lane < lanes; lane++)
+    {
+      result[lane] = -1;
+    }
+
+  //one pass per card keeps every lane loop free of gathers
+  for (card = curse; card <= treasure_map; card++)
+    {
+      cost = getCost(card);
+      supply = batch->supplyCount[card];
+      gained = batch->gainedCount[card];
+      for (lane = 0; lane < lanes; lane++)
+	{
+	  //bought is 0 or 1, so every update below is branch free
+	  bought = (supplyPos[lane] == card) & (numBuys[lane] >= 1)
+	    & (supply[lane] >= 1) & (coins[lane] >= cost);
+	  supply[lane] -= bought;
+	  gained[lane] += bought;
+	  coins[lane] -= bought * cost;
+	  numBuys[lane] -= bought;
+	  phase[lane] += bought * (1 - phase[lane]);
+	  result[lane] -= bought * result[lane];
+	}
+      for (player = 0; player < MAX_PLAYERS; player++)
+	{
+	  full = batch->fullCardCount[player][card];
+	  for (lane = 0; lane < lanes; lane++)
+	    {
+	      full[lane] += (supplyPos[lane] == card) & (result[lane] == 0)
+		& (batch->whoseTurn[lane] == player);
+	    }
+	}
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef _DOMINION_BATCH_H
+#define _DOMINION_BATCH_H
+
+#include "dominion.h"
+
+/* N independent games stored struct-of-arrays, one lane per game, so the
+   batch functions below run the same arithmetic across every lane and
+   the compiler can vectorize the inner lane loops.
+
+   A batch holds the per-turn view of each game: scalars, supply, the
+   current player's hand as card counts and every player's card counts.
+   Load lanes from game states, step them together, then store them back
+   to continue with the scalar API (playCard, endTurn, ...). */
+
+struct gameBatch {
+  int lanes;
+  int* numPlayers;
+  int* whoseTurn;
+  int* phase;
+  int* numActions;
+  int* coins;
+  int* bonusCoins;                           /* the bonus part of coins */
+  int* numBuys;
+  int* supplyCount[treasure_map+1];          /* [card][lane] */
+  int* embargoTokens[treasure_map+1];        /* [card][lane] */
+  int* handCardCount[treasure_map+1];        /* current player's hand, [card][lane] */
+  int* fullCardCount[MAX_PLAYERS][treasure_map+1]; /* [player][card][lane] */
+  int* gainedCount[treasure_map+1];          /* bought since load, [card][lane] */
+  int* storage;                              /* single block behind all lanes */
+};
+
+struct gameBatch* newGameBatch(int lanes);
+/* Returns NULL if lanes < 1 or out of memory */
+
+int freeGameBatch(struct gameBatch *batch);
+
+int loadBatchLane(struct gameBatch *batch, int lane, struct gameState *state);
+/* Copy state's per-turn view into lane */
+
+int storeBatchLane(struct gameBatch *batch, int lane, struct gameState *state);
+/* Write lane back into the state it was loaded from.  Cards bought in
+   the batch are added to the current player's discard pile in card
+   order.  Every write goes through the engine setters, so a journal
+   attached to state can undo the store */
+
+/* Batch versions of the dominion.h functions of the same name.  Each
+   takes or fills one value per lane; a NULL bonus means 0 for every
+   lane */
+
+void batchUpdateCoins(struct gameBatch *batch, int *bonus);
+void batchIsGameOver(struct gameBatch *batch, int *gameOver);
+void batchScoreFor(struct gameBatch *batch, int player, int *score);
+/* Scores hand + deck + discard, Gardens worth 1 VP per 10 cards */
+void batchBuyCard(struct gameBatch *batch, int *restrict supplyPos, int *restrict result);
+/* supplyPos -1 skips a lane; result is 0 for a buy, -1 otherwise */
+
+#endif
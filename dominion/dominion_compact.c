@@ -0,0 +1,356 @@
+#include "dominion_compact.h"
+#include "dominion_helpers.h"
+#include "rngs.h"
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(LEGACY_SHUFFLE) && !defined(LAZY_SHUFFLE)
+static int compareBytes(const void* a, const void* b) {
+  return (int)*(const uint8_t*)a - (int)*(const uint8_t*)b;
+}
+#endif
+
+static int validCount(int count, int max) {
+  return count >= 0 && count <= max;
+}
+
+//pack count ints into bytes, fill the rest of the pile with CARD_NONE
+static int packPile(int *src, uint8_t *dst, int count, int max) {
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      if (src[i] < curse || src[i] > treasure_map)
+	{
+	  return -1;
+	}
+      dst[i] = (uint8_t)src[i];
+    }
+  memset(dst + count, CARD_NONE, max - count);
+  return 0;
+}
+
+static void unpackPile(uint8_t *src, int *dst, int count, int max) {
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      dst[i] = src[i];
+    }
+  for (; i < max; i++)
+    {
+      dst[i] = -1;
+    }
+}
+
+int packGameState(struct gameState *state, struct compactGameState *compact) {
+  int i;
+
+  if (state->numPlayers < 0 || state->numPlayers > MAX_PLAYERS
+      || !validCount(state->playedCardCount, MAX_DECK))
+    {
+      return -1;
+    }
+
+  compact->numPlayers = state->numPlayers;
+  for (i = curse; i <= treasure_map; i++)
+    {
+      compact->supplyCount[i] = state->supplyCount[i];
+      compact->embargoTokens[i] = state->embargoTokens[i];
+    }
+  compact->outpostPlayed = state->outpostPlayed;
+  compact->outpostTurn = state->outpostTurn;
+  compact->whoseTurn = state->whoseTurn;
+  compact->phase = state->phase;
+  compact->numActions = state->numActions;
+  compact->coins = state->coins;
+  compact->bonusCoins = state->bonusCoins;
+  compact->numBuys = state->numBuys;
+  memcpy(compact->deckKnown, state->deckKnown, sizeof(compact->deckKnown));
+  memcpy(compact->shuffles, state->shuffles, sizeof(compact->shuffles));
+  compact->crnSeed = state->crnSeed;
+  compact->rng = state->rng;
+
+  for (i = 0; i < MAX_PLAYERS; i++)
+    {
+      //players not in the game are stored as empty
+      if (i >= state->numPlayers)
+	{
+	  compact->handCount[i] = 0;
+	  compact->deckCount[i] = 0;
+	  compact->discardCount[i] = 0;
+	  compact->deckKnown[i] = 0;
+	  memset(compact->hand[i], CARD_NONE, MAX_HAND);
+	  memset(compact->deck[i], CARD_NONE, MAX_DECK);
+	  memset(compact->discard[i], CARD_NONE, MAX_DECK);
+	  continue;
+	}
+
+      if (!validCount(state->handCount[i], MAX_HAND)
+	  || !validCount(state->deckCount[i], MAX_DECK)
+	  || !validCount(state->discardCount[i], MAX_DECK))
+	{
+	  return -1;
+	}
+
+      compact->handCount[i] = state->handCount[i];
+      compact->deckCount[i] = state->deckCount[i];
+      compact->discardCount[i] = state->discardCount[i];
+      if (packPile(state->hand[i], compact->hand[i], state->handCount[i], MAX_HAND) < 0
+	  || packPile(state->deck[i], compact->deck[i], state->deckCount[i], MAX_DECK) < 0
+	  || packPile(state->discard[i], compact->discard[i], state->discardCount[i], MAX_DECK) < 0)
+	{
+	  return -1;
+	}
+    }
+
+  compact->playedCardCount = state->playedCardCount;
+  return packPile(state->playedCards, compact->playedCards, state->playedCardCount, MAX_DECK);
+}
+
+int unpackGameState(struct compactGameState *compact, struct gameState *state) {
+  int i;
+
+  state->numPlayers = compact->numPlayers;
+  for (i = curse; i <= treasure_map; i++)
+    {
+      state->supplyCount[i] = compact->supplyCount[i];
+      state->embargoTokens[i] = compact->embargoTokens[i];
+    }
+  state->outpostPlayed = compact->outpostPlayed;
+  state->outpostTurn = compact->outpostTurn;
+  state->whoseTurn = compact->whoseTurn;
+  state->phase = compact->phase;
+  state->numActions = compact->numActions;
+  state->coins = compact->coins;
+  state->bonusCoins = compact->bonusCoins;
+  state->numBuys = compact->numBuys;
+  state->journal = NULL;
+  state->rng = compact->rng;
+  state->crnSeed = compact->crnSeed;
+  memcpy(state->shuffles, compact->shuffles, sizeof(state->shuffles));
+
+  for (i = 0; i < MAX_PLAYERS; i++)
+    {
+      state->handCount[i] = compact->handCount[i];
+      state->deckCount[i] = compact->deckCount[i];
+      state->deckKnown[i] = compact->deckKnown[i];
+      state->discardCount[i] = compact->discardCount[i];
+      unpackPile(compact->hand[i], state->hand[i], compact->handCount[i], MAX_HAND);
+      unpackPile(compact->deck[i], state->deck[i], compact->deckCount[i], MAX_DECK);
+      unpackPile(compact->discard[i], state->discard[i], compact->discardCount[i], MAX_DECK);
+    }
+
+  state->playedCardCount = compact->playedCardCount;
+  unpackPile(compact->playedCards, state->playedCards, compact->playedCardCount, MAX_DECK);
+
+  //compact states carry no cached counts, rebuild them
+  state->dirtyPiles = ~0u;
+  return syncGameState(state);
+}
+
+int compactNumHandCards(struct compactGameState *state) {
+  return state->handCount[ compactWhoseTurn(state) ];
+}
+
+int compactHandCard(int handPos, struct compactGameState *state) {
+  int currentPlayer = compactWhoseTurn(state);
+  return state->hand[currentPlayer][handPos];
+}
+
+int compactSupplyCount(int card, struct compactGameState *state) {
+  return state->supplyCount[card];
+}
+
+int compactFullDeckCount(int player, int card, struct compactGameState *state) {
+  int i;
+  int count = 0;
+
+  for (i = 0; i < state->deckCount[player]; i++)
+    {
+      if (state->deck[player][i] == card) count++;
+    }
+
+  for (i = 0; i < state->handCount[player]; i++)
+    {
+      if (state->hand[player][i] == card) count++;
+    }
+
+  for (i = 0; i < state->discardCount[player]; i++)
+    {
+      if (state->discard[player][i] == card) count++;
+    }
+
+  return count;
+}
+
+int compactWhoseTurn(struct compactGameState *state) {
+  return state->whoseTurn;
+}
+
+int compactShuffle(int player, struct compactGameState *state) {
+  int count = state->deckCount[player];
+#if !defined(LAZY_SHUFFLE)
+  int card;
+  int stream;
+#endif
+#if defined(LAZY_SHUFFLE)
+#elif defined(LEGACY_SHUFFLE)
+  double draws[MAX_DECK];
+  uint8_t newDeck[MAX_DECK];
+  int newDeckPos = 0;
+#else
+  uint8_t swap;
+#endif
+
+  if (count < 1)
+    return -1;
+  state->deckKnown[player] = 0;
+  state->shuffles[player]++;
+#if defined(LAZY_SHUFFLE)
+  //no known cards left, drawing picks from the whole deck
+#elif defined(LEGACY_SHUFFLE)
+  qsort ((void*)(state->deck[player]), count, sizeof(uint8_t), compareBytes);
+  /* SORT CARDS IN DECK TO ENSURE DETERMINISM! */
+
+  //same draw sequence as shuffle() so both encodings stay in lockstep
+  stream = enterCrnStream(state->crnSeed, player, state->shuffles[player], 0,
+			  state->rng);
+  RandomFill(state->rng, draws, count);
+  leaveCrnStream(stream, state->rng);
+  while (count > 0) {
+    card = floor(draws[newDeckPos] * count);
+    newDeck[newDeckPos++] = state->deck[player][card];
+    memmove(&state->deck[player][card], &state->deck[player][card+1], count - card - 1);
+    count--;
+  }
+  memcpy(state->deck[player], newDeck, newDeckPos);
+#else
+  //same Fisher-Yates as shuffle()
+  stream = enterCrnStream(state->crnSeed, player, state->shuffles[player], 0,
+			  state->rng);
+  while (--count > 0) {
+    card = RandomInt(state->rng, count + 1);
+    swap = state->deck[player][card];
+    state->deck[player][card] = state->deck[player][count];
+    state->deck[player][count] = swap;
+  }
+  leaveCrnStream(stream, state->rng);
+#endif
+
+  return 0;
+}
+
+#ifdef LAZY_SHUFFLE
+//swap a random card of deck[0..pos] into pos, as pickDeckCard in dominion.c
+static void compactPickDeckCard(int pos, int player, struct compactGameState *state) {
+  int stream = enterCrnStream(state->crnSeed, player, state->shuffles[player], pos,
+			      state->rng);
+  int pick = RandomInt(state->rng, pos + 1);
+  uint8_t card = state->deck[player][pick];
+
+  leaveCrnStream(stream, state->rng);
+  state->deck[player][pick] = state->deck[player][pos];
+  state->deck[player][pos] = card;
+}
+#endif
+
+//a treasure entering or leaving the hand of the player whose turn it is
+//changes the coins to spend, as in the full engine
+static void handCoinsChanged(int player, int card, int delta,
+			     struct compactGameState *state) {
+  if (player == state->whoseTurn && VALID_CARD(card))
+    state->coins += delta * cardTable[card].coins;
+}
+
+int compactDrawCard(int player, struct compactGameState *state) {
+  int count;
+  int deckCounter;
+
+  if (state->deckCount[player] <= 0){//Deck is empty
+
+    //Move discard to deck
+    memcpy(state->deck[player], state->discard[player], state->discardCount[player]);
+    memset(state->discard[player], CARD_NONE, state->discardCount[player]);
+
+    state->deckCount[player] = state->discardCount[player];
+    state->deckKnown[player] = state->discardCount[player];
+    state->discardCount[player] = 0;//Reset discard
+
+    //Shuffle the deck
+    compactShuffle(player, state);
+
+    if (state->deckCount[player] == 0)
+      return -1;
+  }
+
+  count = state->handCount[player];
+  deckCounter = state->deckCount[player];
+#ifdef LAZY_SHUFFLE
+  //a lazily shuffled deck deals its top card now
+  if (state->deckKnown[player] == 0)
+    compactPickDeckCard(deckCounter - 1, player, state);
+#endif
+  state->hand[player][count] = state->deck[player][deckCounter - 1];//Add card to hand
+  state->deckCount[player]--;
+  if (state->deckKnown[player] > 0)
+    state->deckKnown[player]--;
+  state->handCount[player]++;
+  handCoinsChanged(player, state->hand[player][count], 1, state);
+
+  return 0;
+}
+
+int compactDiscardCard(int handPos, int currentPlayer,
+		       struct compactGameState *state, int trashFlag) {
+  int last = state->handCount[currentPlayer] - 1;
+
+  handCoinsChanged(currentPlayer, state->hand[currentPlayer][handPos], -1, state);
+
+  //if card is not trashed, added to Played pile
+  if (trashFlag < 1)
+    {
+      state->playedCards[state->playedCardCount] = state->hand[currentPlayer][handPos];
+      state->playedCardCount++;
+    }
+
+  //replace discarded card with last card in hand
+  state->hand[currentPlayer][handPos] = state->hand[currentPlayer][last];
+  state->hand[currentPlayer][last] = CARD_NONE;
+  state->handCount[currentPlayer]--;
+
+  return 0;
+}
+
+int compactGainCard(int supplyPos, struct compactGameState *state, int toFlag,
+		    int player) {
+  //check if supply pile is empty (0) or card is not used in game (-1)
+  if ( compactSupplyCount(supplyPos, state) < 1 )
+    {
+      return -1;
+    }
+
+  // toFlag = 0 : add to discard
+  // toFlag = 1 : add to deck
+  // toFlag = 2 : add to hand
+  if (toFlag == 1)
+    {
+      state->deck[player][ state->deckCount[player]++ ] = (uint8_t)supplyPos;
+      state->deckKnown[player]++;
+    }
+  else if (toFlag == 2)
+    {
+      state->hand[player][ state->handCount[player]++ ] = (uint8_t)supplyPos;
+      handCoinsChanged(player, supplyPos, 1, state);
+    }
+  else
+    {
+      state->discard[player][ state->discardCount[player]++ ] = (uint8_t)supplyPos;
+    }
+
+  //decrease number in supply pile
+  state->supplyCount[supplyPos]--;
+
+  return 0;
+}
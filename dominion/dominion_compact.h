@@ -0,0 +1,65 @@
+#ifndef _DOMINION_COMPACT_H
+#define _DOMINION_COMPACT_H
+
+#include <stdint.h>
+#include "dominion.h"
+
+/* Compact copy of struct gameState with one byte per card.  Every card
+   enum fits in a uint8_t, so the four pile arrays shrink 4x and the whole
+   state is cheap to clone with memcpy. */
+
+#define CARD_NONE 0xFF /* empty slot, stands in for the -1 used in gameState */
+
+struct compactGameState {
+  int numPlayers;
+  int supplyCount[treasure_map+1];
+  int embargoTokens[treasure_map+1];
+  int outpostPlayed;
+  int outpostTurn;
+  int whoseTurn;
+  int phase;
+  int numActions;
+  int coins;
+  int bonusCoins;                      /* as in gameState */
+  int numBuys;
+  int handCount[MAX_PLAYERS];
+  int deckCount[MAX_PLAYERS];
+  int discardCount[MAX_PLAYERS];
+  int playedCardCount;
+  uint8_t hand[MAX_PLAYERS][MAX_HAND];
+  uint8_t deck[MAX_PLAYERS][MAX_DECK];
+  uint8_t discard[MAX_PLAYERS][MAX_DECK];
+  uint8_t playedCards[MAX_DECK];
+  int deckKnown[MAX_PLAYERS];          /* as in gameState, for lazy shuffles */
+  int shuffles[MAX_PLAYERS];           /* as in gameState, for common random numbers */
+  int crnSeed;
+  struct rngState* rng;                /* shared with the gameState it was packed from */
+};
+
+int packGameState(struct gameState *state, struct compactGameState *compact);
+/* Copy state into compact.  Only the live part of each pile is copied,
+   slots past a pile's count are set to CARD_NONE.  Returns -1 if a count
+   is out of range or a live card is not a valid enum CARD */
+
+int unpackGameState(struct compactGameState *compact, struct gameState *state);
+/* Inverse of packGameState; slots past a pile's count are set to -1 and
+   the cached card counts are rebuilt.  No journal is attached, and every
+   pile is marked dirty since any of them may differ from the last
+   snapshot of state */
+
+/* Same contracts as the functions of the same name in dominion.h and
+   dominion_helpers.h, operating directly on the compact encoding */
+
+int compactNumHandCards(struct compactGameState *state);
+int compactHandCard(int handPos, struct compactGameState *state);
+int compactSupplyCount(int card, struct compactGameState *state);
+int compactFullDeckCount(int player, int card, struct compactGameState *state);
+int compactWhoseTurn(struct compactGameState *state);
+int compactShuffle(int player, struct compactGameState *state);
+int compactDrawCard(int player, struct compactGameState *state);
+int compactDiscardCard(int handPos, int currentPlayer,
+		       struct compactGameState *state, int trashFlag);
+int compactGainCard(int supplyPos, struct compactGameState *state, int toFlag,
+		    int player);
+
+#endif
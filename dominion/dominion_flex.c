@@ -0,0 +1,692 @@
+#include "dominion_flex.h"
+#include "dominion_helpers.h"
+#include "rngs.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int maxPlayers = FLEX_MAX_PLAYERS;
+
+static unsigned char* pileData(struct pile *p) {
+  return p->heap ? p->heap : p->small;
+}
+
+void initPile(struct pile *p) {
+  p->count = 0;
+  p->capacity = PILE_INLINE;
+  p->heap = NULL;
+}
+
+void freePile(struct pile *p) {
+  free(p->heap);
+  initPile(p);
+}
+
+//make room for at least capacity cards, doubling to keep pushes cheap
+static int reservePile(struct pile *p, int capacity) {
+  unsigned char* heap;
+  int newCapacity = p->capacity;
+
+  if (capacity <= p->capacity)
+    {
+      return 0;
+    }
+  while (newCapacity < capacity)
+    {
+      newCapacity *= 2;
+    }
+  heap = malloc(newCapacity);
+  if (heap == NULL)
+    {
+      return -1;
+    }
+  memcpy(heap, pileData(p), p->count);
+  free(p->heap);
+  p->heap = heap;
+  p->capacity = newCapacity;
+  return 0;
+}
+
+int pileCard(struct pile *p, int pos) {
+  if (pos < 0 || pos >= p->count)
+    {
+      return -1;
+    }
+  return pileData(p)[pos];
+}
+
+int setPileSlot(struct pile *p, int pos, int card) {
+  if (pos < 0 || pos >= p->count || card < curse || card > treasure_map)
+    {
+      return -1;
+    }
+  pileData(p)[pos] = (unsigned char)card;
+  return 0;
+}
+
+int pushPile(struct pile *p, int card) {
+  if (card < curse || card > treasure_map || reservePile(p, p->count + 1) < 0)
+    {
+      return -1;
+    }
+  pileData(p)[p->count++] = (unsigned char)card;
+  return 0;
+}
+
+int popPile(struct pile *p) {
+  if (p->count < 1)
+    {
+      return -1;
+    }
+  return pileData(p)[--p->count];
+}
+
+int removePileCard(struct pile *p, int pos) {
+  unsigned char* cards = pileData(p);
+
+  if (pos < 0 || pos >= p->count)
+    {
+      return -1;
+    }
+  cards[pos] = cards[p->count - 1];
+  p->count--;
+  return 0;
+}
+
+int setMaxPlayers(int players) {
+  if (players < 2 || players > SUPPLY_PLAYERS)
+    {
+      return -1;
+    }
+  maxPlayers = players;
+  return 0;
+}
+
+int getMaxPlayers(void) {
+  return maxPlayers;
+}
+
+static int allocPlayers(int numPlayers, struct flexGameState *state) {
+  int i;
+
+  state->players = malloc(numPlayers * sizeof(struct flexPlayer));
+  if (state->players == NULL)
+    {
+      return -1;
+    }
+  state->numPlayers = numPlayers;
+  for (i = 0; i < numPlayers; i++)
+    {
+      initPile(&state->players[i].hand);
+      initPile(&state->players[i].deck);
+      initPile(&state->players[i].discard);
+      state->players[i].deckKnown = 0;
+      state->players[i].shuffles = 0;
+      state->players[i].handCoins = 0;
+    }
+  initPile(&state->playedCards);
+  state->crnSeed = 0;
+  state->rng = NULL;
+  return 0;
+}
+
+int initializeFlexGame(int numPlayers, int kingdomCards[10], int randomSeed,
+		       struct flexGameState *state) {
+  return initializeFlexGameWithRng(numPlayers, kingdomCards, randomSeed, NULL, state);
+}
+
+int initializeFlexGameWithRng(int numPlayers, int kingdomCards[10], int randomSeed,
+			      RngState *rng, struct flexGameState *state) {
+  int i;
+  int j;
+
+  //set up random number generator
+  SelectStreamCtx(rng, 1);
+  PutSeedCtx(rng, (long)randomSeed);
+
+  //check number of players
+  if (numPlayers > maxPlayers || numPlayers < 2)
+    {
+      return -1;
+    }
+
+  //check selected kingdom cards are different
+  for (i = 0; i < 10; i++)
+    {
+      for (j = 0; j < 10; j++)
+	{
+	  if (j != i && kingdomCards[j] == kingdomCards[i])
+	    {
+	      return -1;
+	    }
+	}
+    }
+
+  if (allocPlayers(numPlayers, state) < 0)
+    {
+      return -1;
+    }
+  state->rng = rng;
+
+  //base cards always, kingdom cards only if chosen
+  for (i = curse; i <= treasure_map; i++)
+    {
+      state->supplyCount[i] = (i < adventurer) ? cardTable[i].supply[numPlayers] : -1;
+      for (j = 0; j < 10; j++)
+	{
+	  if (kingdomCards[j] == i)
+	    {
+	      state->supplyCount[i] = cardTable[i].supply[numPlayers];
+	    }
+	}
+    }
+
+  for (i = 0; i <= treasure_map; i++)
+    {
+      state->embargoTokens[i] = 0;
+    }
+
+  //set and shuffle player decks
+  for (i = 0; i < numPlayers; i++)
+    {
+      for (j = 0; j < 3; j++)
+	{
+	  pushPile(&state->players[i].deck, estate);
+	}
+      for (j = 3; j < 10; j++)
+	{
+	  pushPile(&state->players[i].deck, copper);
+	}
+      flexShuffle(i, state);
+    }
+
+  //initialize first player's turn
+  state->outpostPlayed = 0;
+  state->outpostTurn = 0;
+  state->phase = 0;
+  state->numActions = 1;
+  state->numBuys = 1;
+  state->whoseTurn = 0;
+  for (i = 0; i < 5; i++)
+    {
+      flexDrawCard(state->whoseTurn, state);
+    }
+  flexUpdateCoins(state->whoseTurn, state, 0);
+
+  return 0;
+}
+
+int freeFlexGame(struct flexGameState *state) {
+  int i;
+
+  if (state->players == NULL)
+    {
+      return -1;
+    }
+  for (i = 0; i < state->numPlayers; i++)
+    {
+      freePile(&state->players[i].hand);
+      freePile(&state->players[i].deck);
+      freePile(&state->players[i].discard);
+    }
+  freePile(&state->playedCards);
+  free(state->players);
+  state->players = NULL;
+  return 0;
+}
+
+static int pileToArray(struct pile *p, int *cards, int *count, int max) {
+  int i;
+
+  if (p->count > max)
+    {
+      return -1;
+    }
+  for (i = 0; i < p->count; i++)
+    {
+      cards[i] = pileData(p)[i];
+    }
+  *count = p->count;
+  return 0;
+}
+
+static int arrayToPile(int *cards, int count, struct pile *p) {
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      if (pushPile(p, cards[i]) < 0)
+	{
+	  return -1;
+	}
+    }
+  return 0;
+}
+
+int flexToGameState(struct flexGameState *flex, struct gameState *state) {
+  int i;
+  struct flexPlayer* player;
+
+  if (flex->numPlayers > MAX_PLAYERS)
+    {
+      return -1;
+    }
+
+  state->numPlayers = flex->numPlayers;
+  for (i = curse; i <= treasure_map; i++)
+    {
+      state->supplyCount[i] = flex->supplyCount[i];
+      state->embargoTokens[i] = flex->embargoTokens[i];
+    }
+  state->outpostPlayed = flex->outpostPlayed;
+  state->outpostTurn = flex->outpostTurn;
+  state->whoseTurn = flex->whoseTurn;
+  state->phase = flex->phase;
+  state->numActions = flex->numActions;
+  state->coins = flex->coins;
+  state->bonusCoins = flex->bonusCoins;
+  state->numBuys = flex->numBuys;
+  state->journal = NULL;
+  state->rng = flex->rng;
+  state->crnSeed = flex->crnSeed;
+  memset(state->shuffles, 0, sizeof(state->shuffles));
+
+  for (i = 0; i < MAX_PLAYERS; i++)
+    {
+      state->handCount[i] = 0;
+      state->deckCount[i] = 0;
+      state->discardCount[i] = 0;
+      state->deckKnown[i] = 0;
+      if (i >= flex->numPlayers)
+	{
+	  continue;
+	}
+      player = &flex->players[i];
+      state->shuffles[i] = player->shuffles;
+      if (pileToArray(&player->hand, state->hand[i], &state->handCount[i], MAX_HAND) < 0
+	  || pileToArray(&player->deck, state->deck[i], &state->deckCount[i], MAX_DECK) < 0
+	  || pileToArray(&player->discard, state->discard[i], &state->discardCount[i], MAX_DECK) < 0)
+	{
+	  return -1;
+	}
+      state->deckKnown[i] = player->deckKnown;
+    }
+  if (pileToArray(&flex->playedCards, state->playedCards, &state->playedCardCount, MAX_DECK) < 0)
+    {
+      return -1;
+    }
+
+  state->dirtyPiles = ~0u;
+  return syncGameState(state);
+}
+
+int gameStateToFlex(struct gameState *state, struct flexGameState *flex) {
+  int i;
+  struct flexPlayer* player;
+
+  if (state->numPlayers < 2 || state->numPlayers > MAX_PLAYERS
+      || allocPlayers(state->numPlayers, flex) < 0)
+    {
+      return -1;
+    }
+
+  for (i = curse; i <= treasure_map; i++)
+    {
+      flex->supplyCount[i] = state->supplyCount[i];
+      flex->embargoTokens[i] = state->embargoTokens[i];
+    }
+  flex->outpostPlayed = state->outpostPlayed;
+  flex->outpostTurn = state->outpostTurn;
+  flex->whoseTurn = state->whoseTurn;
+  flex->phase = state->phase;
+  flex->numActions = state->numActions;
+  flex->coins = state->coins;
+  flex->bonusCoins = state->bonusCoins;
+  flex->numBuys = state->numBuys;
+  flex->crnSeed = state->crnSeed;
+  flex->rng = state->rng;
+
+  for (i = 0; i < state->numPlayers; i++)
+    {
+      player = &flex->players[i];
+      player->deckKnown = state->deckKnown[i];
+      player->shuffles = state->shuffles[i];
+      player->handCoins = state->handCoins[i];
+      if (arrayToPile(state->hand[i], state->handCount[i], &player->hand) < 0
+	  || arrayToPile(state->deck[i], state->deckCount[i], &player->deck) < 0
+	  || arrayToPile(state->discard[i], state->discardCount[i], &player->discard) < 0)
+	{
+	  freeFlexGame(flex);
+	  return -1;
+	}
+    }
+  if (arrayToPile(state->playedCards, state->playedCardCount, &flex->playedCards) < 0)
+    {
+      freeFlexGame(flex);
+      return -1;
+    }
+
+  return 0;
+}
+
+int flexNumHandCards(struct flexGameState *state) {
+  return state->players[ flexWhoseTurn(state) ].hand.count;
+}
+
+int flexHandCard(int handPos, struct flexGameState *state) {
+  return pileCard(&state->players[ flexWhoseTurn(state) ].hand, handPos);
+}
+
+int flexSupplyCount(int card, struct flexGameState *state) {
+  return state->supplyCount[card];
+}
+
+static int countInPile(struct pile *p, int card) {
+  unsigned char* cards = pileData(p);
+  int count = 0;
+  int i;
+
+  for (i = 0; i < p->count; i++)
+    {
+      if (cards[i] == card) count++;
+    }
+  return count;
+}
+
+int flexFullDeckCount(int player, int card, struct flexGameState *state) {
+  struct flexPlayer* p = &state->players[player];
+
+  return countInPile(&p->deck, card) + countInPile(&p->hand, card)
+    + countInPile(&p->discard, card);
+}
+
+int flexWhoseTurn(struct flexGameState *state) {
+  return state->whoseTurn;
+}
+
+#if defined(LEGACY_SHUFFLE) && !defined(LAZY_SHUFFLE)
+static int compareCards(const void* a, const void* b) {
+  return (int)*(const unsigned char*)a - (int)*(const unsigned char*)b;
+}
+#endif
+
+int flexShuffle(int player, struct flexGameState *state) {
+  struct flexPlayer* p = &state->players[player];
+  int count = p->deck.count;
+#if !defined(LAZY_SHUFFLE)
+  unsigned char* cards = pileData(&p->deck);
+  int card;
+  int stream;
+#endif
+#if defined(LAZY_SHUFFLE)
+#elif defined(LEGACY_SHUFFLE)
+  double draw;
+  unsigned char newDeck[MAX_DECK];
+  unsigned char* shuffled = newDeck;
+  int newDeckPos = 0;
+#else
+  unsigned char swap;
+#endif
+
+  if (count < 1)
+    return -1;
+#if defined(LEGACY_SHUFFLE) && !defined(LAZY_SHUFFLE)
+  if (count > MAX_DECK)
+    {
+      shuffled = malloc(count);
+      if (shuffled == NULL)
+	return -1;
+    }
+#endif
+  p->deckKnown = 0;
+  p->shuffles++;
+#if defined(LAZY_SHUFFLE)
+  //no known cards left, drawing picks from the whole deck
+#elif defined(LEGACY_SHUFFLE)
+  qsort ((void*)cards, count, 1, compareCards);
+  /* SORT CARDS IN DECK TO ENSURE DETERMINISM! */
+
+  //same draw sequence as shuffle(), one draw per card
+  stream = enterCrnStream(state->crnSeed, player, p->shuffles, 0, state->rng);
+  while (count > 0) {
+    RandomFill(state->rng, &draw, 1);
+    card = floor(draw * count);
+    shuffled[newDeckPos++] = cards[card];
+    memmove(&cards[card], &cards[card+1], count - card - 1);
+    count--;
+  }
+  leaveCrnStream(stream, state->rng);
+  memcpy(cards, shuffled, newDeckPos);
+  if (shuffled != newDeck)
+    {
+      free(shuffled);
+    }
+#else
+  //same Fisher-Yates as shuffle(), no buffer needed for big decks
+  stream = enterCrnStream(state->crnSeed, player, p->shuffles, 0, state->rng);
+  while (--count > 0) {
+    card = RandomInt(state->rng, count + 1);
+    swap = cards[card];
+    cards[card] = cards[count];
+    cards[count] = swap;
+  }
+  leaveCrnStream(stream, state->rng);
+#endif
+
+  return 0;
+}
+
+#ifdef LAZY_SHUFFLE
+//swap a random card of the deck's first pos + 1 into pos, as pickDeckCard
+//in dominion.c
+static void flexPickDeckCard(int pos, int player, struct flexGameState *state) {
+  struct flexPlayer* p = &state->players[player];
+  unsigned char* cards = pileData(&p->deck);
+  int stream = enterCrnStream(state->crnSeed, player, p->shuffles, pos, state->rng);
+  int pick = RandomInt(state->rng, pos + 1);
+  unsigned char card = cards[pick];
+
+  leaveCrnStream(stream, state->rng);
+  cards[pick] = cards[pos];
+  cards[pos] = card;
+}
+#endif
+
+//a treasure entering or leaving a hand changes its value, and the coins
+//to spend if it is the hand of the player whose turn it is, as in the
+//full engine
+static void handCoinsChanged(int player, int card, int delta,
+			     struct flexGameState *state) {
+  if (!VALID_CARD(card))
+    return;
+  state->players[player].handCoins += delta * cardTable[card].coins;
+  if (player == state->whoseTurn)
+    state->coins += delta * cardTable[card].coins;
+}
+
+int flexDrawCard(int player, struct flexGameState *state) {
+  struct flexPlayer* p = &state->players[player];
+  struct pile swap;
+  int card;
+
+  if (p->deck.count <= 0){//Deck is empty
+    //the empty deck and the discard pile trade places
+    swap = p->deck;
+    p->deck = p->discard;
+    p->discard = swap;
+    p->deckKnown = p->deck.count;
+
+    //Shuffle the deck
+    flexShuffle(player, state);
+
+    if (p->deck.count == 0)
+      return -1;
+  }
+
+#ifdef LAZY_SHUFFLE
+  //a lazily shuffled deck deals its top card now
+  if (p->deckKnown == 0)
+    flexPickDeckCard(p->deck.count - 1, player, state);
+#endif
+  card = popPile(&p->deck);
+  if (p->deckKnown > 0)
+    p->deckKnown--;
+  if (pushPile(&p->hand, card) < 0)
+    return -1;
+  handCoinsChanged(player, card, 1, state);
+  return 0;
+}
+
+int flexGainCard(int supplyPos, struct flexGameState *state, int toFlag,
+		 int player) {
+  struct flexPlayer* p = &state->players[player];
+  int r;
+
+  //check if supply pile is empty (0) or card is not used in game (-1)
+  if ( flexSupplyCount(supplyPos, state) < 1 )
+    {
+      return -1;
+    }
+
+  // toFlag = 0 : add to discard
+  // toFlag = 1 : add to deck
+  // toFlag = 2 : add to hand
+  if (toFlag == 1)
+    {
+      r = pushPile(&p->deck, supplyPos);
+      if (r == 0)
+	p->deckKnown++;
+    }
+  else if (toFlag == 2)
+    {
+      r = pushPile(&p->hand, supplyPos);
+      if (r == 0)
+	handCoinsChanged(player, supplyPos, 1, state);
+    }
+  else
+    {
+      r = pushPile(&p->discard, supplyPos);
+    }
+  if (r < 0)
+    {
+      return -1;
+    }
+
+  //decrease number in supply pile
+  state->supplyCount[supplyPos]--;
+
+  return 0;
+}
+
+int flexDiscardCard(int handPos, int currentPlayer,
+		    struct flexGameState *state, int trashFlag) {
+  struct pile* hand = &state->players[currentPlayer].hand;
+
+  //if card is not trashed, added to Played pile
+  if (trashFlag < 1)
+    {
+      pushPile(&state->playedCards, pileCard(hand, handPos));
+    }
+
+  handCoinsChanged(currentPlayer, pileCard(hand, handPos), -1, state);
+  return removePileCard(hand, handPos);
+}
+
+int flexUpdateCoins(int player, struct flexGameState *state, int bonus) {
+  //treasure in player's hand, kept up to date as cards come and go, plus the bonus
+  state->coins = state->players[player].handCoins + bonus;
+  state->bonusCoins = bonus;
+  return 0;
+}
+
+int flexBuyCard(int supplyPos, struct flexGameState *state) {
+  if (state->numBuys < 1 || flexSupplyCount(supplyPos, state) < 1
+      || state->coins < getCost(supplyPos))
+    {
+      return -1;
+    }
+
+  state->phase = 1;
+  flexGainCard(supplyPos, state, 0, state->whoseTurn);
+  state->coins = state->coins - getCost(supplyPos);
+  state->numBuys--;
+
+  return 0;
+}
+
+int flexEndTurn(struct flexGameState *state) {
+  int k;
+  struct flexPlayer* p = &state->players[ flexWhoseTurn(state) ];
+
+  //Discard hand in hand order
+  for (k = 0; k < p->hand.count; k++)
+    {
+      pushPile(&p->discard, pileData(&p->hand)[k]);
+    }
+  p->hand.count = 0;
+  p->handCoins = 0;
+
+  state->whoseTurn = (state->whoseTurn + 1) % state->numPlayers;
+  state->outpostPlayed = 0;
+  state->phase = 0;
+  state->numActions = 1;
+  state->coins = 0;
+  state->numBuys = 1;
+  state->playedCards.count = 0;
+  state->players[state->whoseTurn].hand.count = 0;
+  state->players[state->whoseTurn].handCoins = 0;
+
+  //Next player draws hand
+  for (k = 0; k < 5; k++){
+    flexDrawCard(state->whoseTurn, state);
+  }
+
+  //Update money
+  flexUpdateCoins(state->whoseTurn, state, 0);
+
+  return 0;
+}
+
+int flexIsGameOver(struct flexGameState *state) {
+  int i;
+  int j = 0;
+
+  //if stack of Province cards is empty, the game ends
+  if (state->supplyCount[province] == 0)
+    {
+      return 1;
+    }
+
+  //if three supply pile are at 0, the game ends
+  for (i = 0; i <= treasure_map; i++)
+    {
+      if (state->supplyCount[i] == 0)
+	{
+	  j++;
+	}
+    }
+
+  return j >= 3;
+}
+
+int flexScoreFor(int player, struct flexGameState *state) {
+  struct flexPlayer* p = &state->players[player];
+  struct pile* piles[3] = {&p->hand, &p->deck, &p->discard};
+  int total = p->hand.count + p->deck.count + p->discard.count;
+  int score = 0;
+  int gardenCards = 0;
+  unsigned char* cards;
+  int i;
+  int j;
+
+  for (i = 0; i < 3; i++)
+    {
+      cards = pileData(piles[i]);
+      for (j = 0; j < piles[i]->count; j++)
+	{
+	  score += cardTable[cards[j]].vp;
+	  gardenCards += (cards[j] == gardens);
+	}
+    }
+  return score + gardenCards * (total / 10);
+}
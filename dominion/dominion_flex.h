@@ -0,0 +1,123 @@
+#ifndef _DOMINION_FLEX_H
+#define _DOMINION_FLEX_H
+
+#include "dominion.h"
+
+/* Game state whose piles grow with the cards actually in them and whose
+   player count is chosen at run time.  A pile keeps its first
+   PILE_INLINE cards inside the struct and moves to the heap only when it
+   outgrows them, so a typical 10-40 card deck never allocates.
+
+   What a flexGameState supports for any 2..getMaxPlayers() players is
+   the treasure and buy game: setup, drawing and shuffling, gaining,
+   discarding and trashing from hand, buying, cleanup, the game end and
+   scoring (the flex* functions below).  Action cards are not played on
+   it: cardEffect and the card handlers only run on a struct gameState,
+   so convert with flexToGameState/gameStateToFlex, which is possible up
+   to MAX_PLAYERS players only.  Five and six player games therefore
+   cannot play action cards without recompiling with a larger
+   MAX_PLAYERS.  The flex functions repeat the rules of their dominion.c
+   counterparts; testFlex plays both in lockstep to keep them the same.
+
+   Of the caches a gameState keeps, a flexGameState keeps only each
+   hand's treasure value.  There is no hash, move journal, dirty pile
+   mask, card tallies, victory point or empty pile count: scoring and the
+   game end are computed from the piles, and flexToGameState rebuilds the
+   rest */
+
+#define PILE_INLINE 16
+#define FLEX_MAX_PLAYERS SUPPLY_PLAYERS /* default run-time player limit */
+
+struct pile {
+  int count;
+  int capacity;
+  unsigned char* heap;              /* NULL while the cards fit in small */
+  unsigned char small[PILE_INLINE];
+};
+
+struct flexPlayer {
+  struct pile hand;
+  struct pile deck;
+  struct pile discard;
+  int deckKnown;                    /* as in gameState, for lazy shuffles */
+  int shuffles;                     /* times the deck was shuffled */
+  int handCoins;                    /* treasure value of the hand */
+};
+
+struct flexGameState {
+  int numPlayers;
+  int supplyCount[treasure_map+1];
+  int embargoTokens[treasure_map+1];
+  int outpostPlayed;
+  int outpostTurn;
+  int whoseTurn;
+  int phase;
+  int numActions;
+  int coins;
+  int bonusCoins;                   /* as in gameState */
+  int numBuys;
+  struct pile playedCards;
+  struct flexPlayer* players;       /* numPlayers entries */
+  int crnSeed;                      /* as in gameState */
+  struct rngState* rng;             /* NULL for the global streams */
+};
+
+/* Piles; all return -1 on failure unless noted */
+
+void initPile(struct pile *p);
+void freePile(struct pile *p);
+int pileCard(struct pile *p, int pos);        /* -1 if pos is out of range */
+int setPileSlot(struct pile *p, int pos, int card);
+int pushPile(struct pile *p, int card);       /* grows the pile as needed */
+int popPile(struct pile *p);                  /* top card, -1 if empty */
+int removePileCard(struct pile *p, int pos);  /* last card fills the gap */
+
+/* Run-time player limit, FLEX_MAX_PLAYERS by default */
+
+int setMaxPlayers(int maxPlayers);
+/* -1 unless 2 <= maxPlayers <= SUPPLY_PLAYERS, the largest game the
+   supply sizes in cardTable cover */
+int getMaxPlayers(void);
+
+int initializeFlexGame(int numPlayers, int kingdomCards[10], int randomSeed,
+		       struct flexGameState *state);
+/* Same setup as initializeGame for any 2..getMaxPlayers() players, with
+   the supply sizes cardTable gives for that many players */
+
+int initializeFlexGameWithRng(int numPlayers, int kingdomCards[10], int randomSeed,
+			      struct rngState *rng, struct flexGameState *state);
+/* initializeFlexGame drawing from rng, as initializeGameWithRng does */
+
+int freeFlexGame(struct flexGameState *state);
+/* Release the pile and player storage of an initialized state */
+
+int flexToGameState(struct flexGameState *flex, struct gameState *state);
+/* -1 if flex has more than MAX_PLAYERS players or a pile is too big.
+   Both conversions carry the random number context, the common random
+   numbers seed and shuffle counts and how much of each deck is in a
+   known order over.  flexToGameState marks every pile of state dirty */
+int gameStateToFlex(struct gameState *state, struct flexGameState *flex);
+/* flex must be uninitialized or already freed */
+
+/* Same contracts as the functions of the same name in dominion.h and
+   dominion_helpers.h */
+
+int flexNumHandCards(struct flexGameState *state);
+int flexHandCard(int handPos, struct flexGameState *state);
+int flexSupplyCount(int card, struct flexGameState *state);
+int flexFullDeckCount(int player, int card, struct flexGameState *state);
+int flexWhoseTurn(struct flexGameState *state);
+int flexShuffle(int player, struct flexGameState *state);
+int flexDrawCard(int player, struct flexGameState *state);
+int flexGainCard(int supplyPos, struct flexGameState *state, int toFlag,
+		 int player);
+int flexDiscardCard(int handPos, int currentPlayer,
+		    struct flexGameState *state, int trashFlag);
+int flexUpdateCoins(int player, struct flexGameState *state, int bonus);
+int flexBuyCard(int supplyPos, struct flexGameState *state);
+int flexEndTurn(struct flexGameState *state);
+int flexIsGameOver(struct flexGameState *state);
+int flexScoreFor(int player, struct flexGameState *state);
+/* Scores hand + deck + discard, Gardens worth 1 VP per 10 cards */
+
+#endif
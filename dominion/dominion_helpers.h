@@ -9,6 +9,18 @@ int discardCard(int handPos, int currentPlayer, struct gameState *state,
 		int trashFlag);
 int gainCard(int supplyPos, struct gameState *state, int toFlag, int player);
 int getCost(int cardNumber);
+int setPileCard(int pos, int card, int pile, int player,
+		struct gameState *state);
+int setPileCount(int count, int pile, int player, struct gameState *state);
+int pushCard(int card, int pile, int player, struct gameState *state);
+int popCard(int pile, int player, struct gameState *state);
+int setSupplyCount(int card, int count, struct gameState *state);
+int setEmbargoTokens(int card, int tokens, struct gameState *state);
+int setTurnScalars(int phase, int numActions, int numBuys, int coins,
+		   int bonusCoins, struct gameState *state);
+int enterCrnStream(int crnSeed, int player, int shuffles, int draw,
+		   struct rngState *rng);
+void leaveCrnStream(int stream, struct rngState *rng);
 int cardEffect(int card, int choice1, int choice2, int choice3, 
 	       struct gameState *state, int handPos, int *bonus);
 
@@ -11,132 +11,17 @@ Sam Heinith CS362
 #include "rngs.h"
 #include "interface.h"
 #include "dominion.h"
+#include "dominion_helpers.h"
 
 
 void cardNumToName(int card, char *name){
-  switch(card){
-  case curse: strcpy(name,"Curse");
-    break;
-  case estate: strcpy(name,"Estate");
-    break;
-  case duchy: strcpy(name,"Duchy");
-    break;
-  case province: strcpy(name,"Province");
-    break;
-  case copper: strcpy(name,"Copper");
-    break;
-  case silver: strcpy(name,"Silver");
-    break;
-  case gold: strcpy(name,"Gold");
-    break;
-  case adventurer: strcpy(name,"Adventurer");
-    break;
-  case council_room: strcpy(name,"Council Room");
-    break;
-  case feast: strcpy(name,"Feast");
-    break;
-  case gardens: strcpy(name,"Gardens");
-    break;
-  case mine: strcpy(name,"Mine");
-    break;
-  case remodel: strcpy(name,"Remodel");
-    break;
-  case smithy: strcpy(name,"Smithy");
-    break;
-  case village: strcpy(name,"Village");
-    break;
-  case baron: strcpy(name,"Baron");
-    break;
-  case great_hall: strcpy(name,"Great Hall");
-    break;
-  case minion: strcpy(name,"Minion");
-    break;
-  case steward: strcpy(name,"Steward");
-    break;
-  case tribute: strcpy(name,"Tribute");
-    break;
-  case ambassador: strcpy(name,"Ambassador");
-    break;
-  case cutpurse: strcpy(name,"Cutpurse");
-    break;
-  case embargo: strcpy(name,"Embargo");
-    break;
-  case outpost: strcpy(name,"Outpost");
-    break;
-  case salvager: strcpy(name,"Salvager");
-    break;
-  case sea_hag: strcpy(name,"Sea Hag");
-    break;
-  case treasure_map: strcpy(name,"Treasure Map");
-    break;
-
-  default: strcpy(name,"?");
-  }
-
+  strcpy(name, VALID_CARD(card) ? cardTable[card].name : "?");
 }
 
 
 
 int getCardCost(int card) {
-  int cost;
-  switch(card) {
-  case curse: cost = CURSE_COST;
-    break;
-  case estate: cost = ESTATE_COST;
-    break;
-  case duchy: cost = DUCHY_COST;
-    break;
-  case province: cost = PROVINCE_COST;
-    break;
-  case copper: cost = COPPER_COST;
-    break;
-  case silver: cost = SILVER_COST;
-    break;
-  case gold: cost = GOLD_COST;
-    break;
-  case adventurer: cost = ADVENTURER_COST;
-    break;
-  case council_room: cost = COUNCIL_ROOM_COST;
-    break;
-  case feast: cost = FEAST_COST;
-    break;
-  case gardens: cost = GARDEN_COST;
-    break;
-  case mine:  cost = MINE_COST;
-    break;
-  case remodel: cost = REMODEL_COST;
-    break;
-  case smithy: cost = SMITHY_COST;
-    break;
-  case village: cost = VILLAGE_COST;
-    break;
-  case baron: cost = BARON_COST;
-    break;
-  case great_hall: cost = GREAT_HALL_COST;
-    break;
-  case minion: cost = MINION_COST;
-    break;
-  case steward: cost = STEWARD_COST;
-    break;
-  case tribute: cost = TRIBUTE_COST;
-    break;
-  case ambassador: cost = AMBASSADOR_COST;
-    break;
-  case cutpurse: cost = CUTPURSE_COST;
-    break;
-  case embargo: cost = EMBARGO_COST;
-    break;
-  case outpost: cost = OUTPOST_COST;
-    break;
-  case salvager: cost = SALVAGER_COST;
-    break;
-  case sea_hag: cost = SEA_HAG_COST;
-    break;
-  case treasure_map: cost = TREASURE_MAP_COST;
-    break;
-  default: cost = ONETHOUSAND;
-  }
-  return cost;
+  return VALID_CARD(card) ? cardTable[card].cost : ONETHOUSAND;
 }
 
 
@@ -277,10 +162,7 @@ void phaseNumToName(int phase, char *name) {
 
 int addCardToHand(int player, int card, struct gameState *game) {
   if(card >= adventurer && card < NUM_TOTAL_K_CARDS){
-    int handTop = game->handCount[player];
-    game->hand[player][handTop] = card;
-    game->handCount[player]++;
-    return SUCCESS;
+    return pushCard(card, hand_pile, player, game);
   } else {
     return FAILURE;
   }
@@ -288,14 +170,18 @@ int addCardToHand(int player, int card, struct gameState *game) {
 }
 
 void selectKingdomCards(int randomSeed, int kingCards[NUM_K_CARDS]) {
+  selectKingdomCardsCtx(NULL, randomSeed, kingCards);
+}
+
+void selectKingdomCardsCtx(RngState *rng, int randomSeed, int kingCards[NUM_K_CARDS]) {
    int i, used, card, numSelected = 0;
-   SelectStream(1);
-	PutSeed((long)randomSeed);
+   SelectStreamCtx(rng, 1);
+	PutSeedCtx(rng, (long)randomSeed);
  
 	
   while(numSelected < NUM_K_CARDS) {
     used = FALSE;
-    card = floor(Random() * NUM_TOTAL_K_CARDS);
+    card = floor(RandomCtx(rng) * NUM_TOTAL_K_CARDS);
     if(card < adventurer) continue;
     for(i = 0; i < numSelected; i++) {
       if(kingCards[i] == card) {
@@ -311,20 +197,7 @@ void selectKingdomCards(int randomSeed, int kingCards[NUM_K_CARDS]) {
 
 
 int countHandCoins(int player, struct gameState *game) {
-  int card, index, coinage = 0;
-	
-  for(index = 0; index < game->handCount[player]; index++) {
-    card = game->hand[player][index];
-    switch(card) {
-    case copper: coinage += COPPER_VALUE;
-      break;
-    case silver: coinage += SILVER_VALUE;
-      break;
-    case gold: coinage += GOLD_VALUE;
-      break;
-    }
-  }
-  return coinage;
+  return game->handCoins[player];
 }
 
 
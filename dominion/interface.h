@@ -46,42 +46,42 @@
 #define BUY_PHASE 1
 #define CLEANUP_PHASE 2
 
-#define COPPER_VALUE 1
-#define SILVER_VALUE 2
-#define GOLD_VALUE 3
-
-//From Dominion List Spoiler
-#define COPPER_COST 0
-#define SILVER_COST 3
-#define GOLD_COST 6
-#define ESTATE_COST 2
-#define DUCHY_COST 5
-#define PROVINCE_COST 8
-#define CURSE_COST 0
-#define ADVENTURER_COST 6
-#define COUNCIL_ROOM_COST 5
-#define FEAST_COST 4
-#define GARDEN_COST 4
-#define MINE_COST 5
+#define COPPER_VALUE (cardTable[copper].coins)
+#define SILVER_VALUE (cardTable[silver].coins)
+#define GOLD_VALUE (cardTable[gold].coins)
+
+//From cardTable, or the Dominion List Spoiler for cards not in this game
+#define COPPER_COST (cardTable[copper].cost)
+#define SILVER_COST (cardTable[silver].cost)
+#define GOLD_COST (cardTable[gold].cost)
+#define ESTATE_COST (cardTable[estate].cost)
+#define DUCHY_COST (cardTable[duchy].cost)
+#define PROVINCE_COST (cardTable[province].cost)
+#define CURSE_COST (cardTable[curse].cost)
+#define ADVENTURER_COST (cardTable[adventurer].cost)
+#define COUNCIL_ROOM_COST (cardTable[council_room].cost)
+#define FEAST_COST (cardTable[feast].cost)
+#define GARDEN_COST (cardTable[gardens].cost)
+#define MINE_COST (cardTable[mine].cost)
 #define MONEYLENDER_COST 4
-#define REMODEL_COST 4
-#define SMITHY_COST 4
-#define VILLAGE_COST 3
+#define REMODEL_COST (cardTable[remodel].cost)
+#define SMITHY_COST (cardTable[smithy].cost)
+#define VILLAGE_COST (cardTable[village].cost)
 #define WOODCUTTER_COST 3
-#define BARON_COST 4
-#define GREAT_HALL_COST 3
-#define MINION_COST 5
+#define BARON_COST (cardTable[baron].cost)
+#define GREAT_HALL_COST (cardTable[great_hall].cost)
+#define MINION_COST (cardTable[minion].cost)
 #define SHANTY_TOWN_COST 3
-#define STEWARD_COST 3
-#define TRIBUTE_COST 5
+#define STEWARD_COST (cardTable[steward].cost)
+#define TRIBUTE_COST (cardTable[tribute].cost)
 #define WISHING_WELL_COST 3
-#define AMBASSADOR_COST 3
-#define CUTPURSE_COST 4
-#define EMBARGO_COST 2
-#define OUTPOST_COST 5
-#define SALVAGER_COST 4
-#define SEA_HAG_COST 4
-#define TREASURE_MAP_COST 4
+#define AMBASSADOR_COST (cardTable[ambassador].cost)
+#define CUTPURSE_COST (cardTable[cutpurse].cost)
+#define EMBARGO_COST (cardTable[embargo].cost)
+#define OUTPOST_COST (cardTable[outpost].cost)
+#define SALVAGER_COST (cardTable[salvager].cost)
+#define SEA_HAG_COST (cardTable[sea_hag].cost)
+#define TREASURE_MAP_COST (cardTable[treasure_map].cost)
 #define ONETHOUSAND 1000
 
 
@@ -117,6 +117,9 @@ void printScores(struct gameState *game);
 
 void selectKingdomCards(int randomSeed, int kingdomCards[NUM_K_CARDS]);
 
+void selectKingdomCardsCtx(struct rngState *rng, int randomSeed,
+			   int kingdomCards[NUM_K_CARDS]);
+
 
 
 #endif
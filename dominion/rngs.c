@@ -33,22 +33,164 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include "rngs.h"
 
 #define MODULUS    2147483647 /* DON'T CHANGE THIS VALUE                  */
 #define MULTIPLIER 48271      /* DON'T CHANGE THIS VALUE                  */
 #define CHECK      399268537  /* DON'T CHANGE THIS VALUE                  */
-#define STREAMS    256        /* # of streams, DON'T CHANGE THIS VALUE    */
+#define STREAMS    RNG_STREAMS /* # of streams, DON'T CHANGE THIS VALUE */
 #define A256       22925      /* jump multiplier, DON'T CHANGE THIS VALUE */
 #define DEFAULT    123456789  /* initial seed, use 0 < DEFAULT < MODULUS  */
       
-static long seed[STREAMS] = {DEFAULT};  /* current state of each stream   */
-static int  stream        = 0;          /* stream index, 0 is the default */
-static int  initialized   = 0;          /* test for stream initialization */
+/* used by the old API and for NULL */
+static RngState global = {{DEFAULT}, 0, 0, RNG_DEFAULT_GENERATOR};
 
+#define CONTEXT(rng) ((rng) == NULL ? &global : (rng))
 
-   double Random(void)
+
+/* xoshiro256** by David Blackman and Sebastiano Vigna, public domain */
+
+static unsigned long long rotl(unsigned long long x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+static unsigned long long splitmix64(unsigned long long *x)
+{
+  unsigned long long z = (*x += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void xoshiroSeed(unsigned long long *s, long x)
+{
+  unsigned long long z = (unsigned long long) x;
+  int j;
+
+  for (j = 0; j < 4; j++)
+    s[j] = splitmix64(&z);
+}
+
+static unsigned long long xoshiroNext(unsigned long long *s)
+{
+  unsigned long long result;
+  unsigned long long t;
+
+  if ((s[0] | s[1] | s[2] | s[3]) == 0)  /* never seeded, the one bad state */
+    xoshiroSeed(s, DEFAULT);
+  result = rotl(s[1] * 5, 7) * 9;
+  t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+/* the top 53 bits as a double in [0, 1); signed converts faster */
+#define XOSHIRO_DOUBLE(s) \
+  ((double) (long long) (xoshiroNext(s) >> 11) * (1.0 / 9007199254740992.0))
+
+/* advance by 2^128 steps, to space the streams apart */
+static void xoshiroJump(unsigned long long *s)
+{
+  static const unsigned long long JUMP[4] =
+    {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+     0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+  unsigned long long t[4] = {0, 0, 0, 0};
+  int i;
+  int b;
+  int j;
+
+  for (i = 0; i < 4; i++)
+    for (b = 0; b < 64; b++) {
+      if (JUMP[i] & (1ULL << b))
+        for (j = 0; j < 4; j++)
+          t[j] ^= s[j];
+      xoshiroNext(s);
+    }
+  for (j = 0; j < 4; j++)
+    s[j] = t[j];
+}
+
+
+   void InitRngState(RngState *rng)
+/* ---------------------------------------------------------------
+ * Use this function to put a context in the state the global
+ * streams start in: stream 0 selected, seeded with DEFAULT.
+ * ---------------------------------------------------------------
+ */
+{
+  int j;
+
+  rng = CONTEXT(rng);
+  rng->seed[0] = DEFAULT;
+  for (j = 1; j < STREAMS; j++)
+    rng->seed[j] = 0;
+  rng->stream      = 0;
+  rng->initialized = 0;
+  rng->generator   = RNG_DEFAULT_GENERATOR;
+  memset(rng->xoshiro, 0, sizeof(rng->xoshiro));
+}
+
+
+   int SelectGeneratorCtx(RngState *rng, int generator)
+/* ---------------------------------------------------------------
+ * Use this function to start a context over on another generator,
+ * as InitRngState leaves it.  Returns -1 for an unknown generator.
+ * ---------------------------------------------------------------
+ */
+{
+  if (generator != RNG_LEHMER && generator != RNG_XOSHIRO256)
+    return -1;
+  rng = CONTEXT(rng);
+  InitRngState(rng);
+  rng->generator = generator;
+  return 0;
+}
+
+
+   int GetGeneratorCtx(RngState *rng)
+{
+  return CONTEXT(rng)->generator;
+}
+
+
+   void GetPositionCtx(RngState *rng, RngPosition *position)
+/* ---------------------------------------------------------------
+ * Use this function to save the current stream and where it is, for
+ * either generator.  GetSeed only does this for the Lehmer one.
+ * ---------------------------------------------------------------
+ */
+{
+  rng = CONTEXT(rng);
+  position->stream = rng->stream;
+  position->seed = rng->seed[rng->stream];
+  memcpy(position->xoshiro, rng->xoshiro[rng->stream], sizeof(position->xoshiro));
+}
+
+
+   void SetPositionCtx(RngState *rng, RngPosition *position)
+/* ---------------------------------------------------------------
+ * Use this function to select a saved stream and put it back where
+ * it was.
+ * ---------------------------------------------------------------
+ */
+{
+  rng = CONTEXT(rng);
+  SelectStreamCtx(rng, position->stream);
+  rng->seed[rng->stream] = position->seed;
+  memcpy(rng->xoshiro[rng->stream], position->xoshiro, sizeof(position->xoshiro));
+}
+
+
+   double RandomCtx(RngState *rng)
 /* ----------------------------------------------------------------
  * Random returns a pseudo-random real number uniformly distributed 
  * between 0.0 and 1.0. 
@@ -58,7 +200,11 @@ static int  initialized   = 0;          /* test for stream initialization */
   const long Q = MODULUS / MULTIPLIER;
   const long R = MODULUS % MULTIPLIER;
         long t;
+        long *seed = CONTEXT(rng)->seed;
+        int  stream = CONTEXT(rng)->stream;
 
+  if (CONTEXT(rng)->generator == RNG_XOSHIRO256)
+    return XOSHIRO_DOUBLE(CONTEXT(rng)->xoshiro[stream]);
   t = MULTIPLIER * (seed[stream] % Q) - R * (seed[stream] / Q);
   if (t > 0) 
     seed[stream] = t;
@@ -68,7 +214,7 @@ static int  initialized   = 0;          /* test for stream initialization */
 }
 
 
-   void PlantSeeds(long x)
+   void PlantSeedsCtx(RngState *rng, long x)
 /* ---------------------------------------------------------------------
  * Use this function to set the state of all the random number generator 
  * streams by "planting" a sequence of states (seeds), one per stream, 
@@ -82,23 +228,30 @@ static int  initialized   = 0;          /* test for stream initialization */
   const long R = MODULUS % A256;
         int  j;
         int  s;
+        long *seed;
 
-  initialized = 1;
-  s = stream;                            /* remember the current stream */
-  SelectStream(0);                       /* change to stream 0          */
-  PutSeed(x);                            /* set seed[0]                 */
-  stream = s;                            /* reset the current stream    */
+  rng = CONTEXT(rng);
+  seed = rng->seed;
+  rng->initialized = 1;
+  s = rng->stream;                       /* remember the current stream */
+  SelectStreamCtx(rng, 0);               /* change to stream 0          */
+  PutSeedCtx(rng, x);                    /* set seed[0]                 */
+  rng->stream = s;                       /* reset the current stream    */
   for (j = 1; j < STREAMS; j++) {
     x = A256 * (seed[j - 1] % Q) - R * (seed[j - 1] / Q);
     if (x > 0)
       seed[j] = x;
     else
       seed[j] = x + MODULUS;
+    if (rng->generator == RNG_XOSHIRO256) {  /* 2^128 apart */
+      memcpy(rng->xoshiro[j], rng->xoshiro[j - 1], sizeof(rng->xoshiro[j]));
+      xoshiroJump(rng->xoshiro[j]);
+    }
    }
 }
 
 
-   void PutSeed(long x)
+   void PutSeedCtx(RngState *rng, long x)
 /* ---------------------------------------------------------------
  * Use this function to set the state of the current random number 
  * generator stream according to the following conventions:
@@ -122,31 +275,259 @@ static int  initialized   = 0;          /* test for stream initialization */
       if (!ok)
         printf("\nInput out of range ... try again\n");
     }
-  seed[stream] = x;
+  rng = CONTEXT(rng);
+  rng->seed[rng->stream] = x;
+  if (rng->generator == RNG_XOSHIRO256)
+    xoshiroSeed(rng->xoshiro[rng->stream], x);
 }
 
 
-   void GetSeed(long *x)
+   void GetSeedCtx(RngState *rng, long *x)
 /* ---------------------------------------------------------------
  * Use this function to get the state of the current random number 
  * generator stream.                                                   
  * ---------------------------------------------------------------
  */
 {
-  *x = seed[stream];
+  rng = CONTEXT(rng);
+  *x = rng->seed[rng->stream];
 }
 
 
-   void SelectStream(int index)
+   int GetStreamCtx(RngState *rng)
+/* ------------------------------------------------------------------
+ * Use this function to get the index of the current random number
+ * generator stream.
+ * ------------------------------------------------------------------
+ */
+{
+  return CONTEXT(rng)->stream;
+}
+
+
+   void SelectStreamCtx(RngState *rng, int index)
 /* ------------------------------------------------------------------
  * Use this function to set the current random number generator
  * stream -- that stream from which the next random number will come.
  * ------------------------------------------------------------------
  */
 {
-  stream = ((unsigned int) index) % STREAMS;
-  if ((initialized == 0) && (stream != 0))   /* protect against        */
-    PlantSeeds(DEFAULT);                     /* un-initialized streams */
+  rng = CONTEXT(rng);
+  rng->stream = ((unsigned int) index) % STREAMS;
+  if ((rng->initialized == 0) && (rng->stream != 0)) /* protect against        */
+    PlantSeedsCtx(rng, DEFAULT);                     /* un-initialized streams */
+}
+
+
+/* seed * MULTIPLIER mod MODULUS with one 64-bit multiply and no
+   division: MODULUS is 2^31 - 1, so the high bits fold onto the low.
+   Two folds always suffice, and the result is never MODULUS itself
+   since the product of two nonzero residues is nonzero */
+#define NEXT_SEED(x, t)                          \
+  ((t) = (long long) (x) * MULTIPLIER,           \
+   (t) = ((t) & MODULUS) + ((t) >> 31),          \
+   ((t) & MODULUS) + ((t) >> 31))
+
+
+   int RandomInt(RngState *rng, int n)
+/* ------------------------------------------------------------------
+ * RandomInt returns an integer uniformly distributed between 0 and
+ * n - 1, or -1 if n < 1.  The MODULUS - 1 states are split into n
+ * equal buckets and states past the last whole bucket are drawn
+ * again, so unlike floor(Random() * n) there is no bias and no
+ * floating point.  Usually one draw, at worst n / MODULUS retries.
+ * xoshiro256** uses the top 32 bits of each value and Lemire's
+ * multiply-shift with the same kind of rejection.
+ * ------------------------------------------------------------------
+ */
+{
+  long long t;
+  long      bucket;
+  long      x;
+  long      *seed;
+  unsigned long long m;
+  unsigned long      low;
+
+  if (n < 1)
+    return -1;
+  rng = CONTEXT(rng);
+  if (rng->generator == RNG_XOSHIRO256) {
+    m = (xoshiroNext(rng->xoshiro[rng->stream]) >> 32) * (unsigned long long) n;
+    low = (unsigned long) (m & 0xffffffffUL);
+    if (low < (unsigned long) n) {
+      bucket = (long) ((0x100000000ULL - n) % n);  /* 2^32 mod n */
+      while (low < (unsigned long) bucket) {
+        m = (xoshiroNext(rng->xoshiro[rng->stream]) >> 32) * (unsigned long long) n;
+        low = (unsigned long) (m & 0xffffffffUL);
+      }
+    }
+    return (int) (m >> 32);
+  }
+  seed = &rng->seed[rng->stream];
+  bucket = (MODULUS - 1) / n;
+  do {
+    *seed = (long) NEXT_SEED(*seed, t);
+    x = *seed - 1;                           /* 0 .. MODULUS - 2 */
+  } while (x >= bucket * n);
+  return (int) (x / bucket);
+}
+
+
+   int RandomIntLegacy(RngState *rng, int n)
+/* ------------------------------------------------------------------
+ * The mapping the engine has always used, floor(Random() * n), for
+ * code that must reproduce existing sequences.
+ * ------------------------------------------------------------------
+ */
+{
+  if (n < 1)
+    return -1;
+  return (int) (RandomCtx(rng) * n);
+}
+
+
+   void RandomFill(RngState *rng, double *out, int n)
+/* ------------------------------------------------------------------
+ * Use this function to get the next n values of the current stream
+ * at once: out[i] is what the i-th of n calls to Random() would
+ * return, and the stream ends where those calls would leave it.
+ * ------------------------------------------------------------------
+ */
+{
+  long long x;
+  long long t;
+  int       i;
+
+  rng = CONTEXT(rng);
+  if (rng->generator == RNG_XOSHIRO256) {
+    unsigned long long s[4];               /* in registers for the loop */
+
+    memcpy(s, rng->xoshiro[rng->stream], sizeof(s));
+    for (i = 0; i < n; i++)
+      out[i] = XOSHIRO_DOUBLE(s);
+    memcpy(rng->xoshiro[rng->stream], s, sizeof(s));
+    return;
+  }
+  x = rng->seed[rng->stream];
+  for (i = 0; i < n; i++) {
+    x = NEXT_SEED(x, t);
+    out[i] = (double) x / MODULUS;
+  }
+  rng->seed[rng->stream] = (long) x;
+}
+
+
+   void RandomFillStreams(RngState *rng, int first, int lanes, double *out, int n)
+/* ------------------------------------------------------------------
+ * Use this function to draw n values from each of the lanes streams
+ * first, first + 1, ... at once, interleaved: out[i * lanes + j] is
+ * the i-th value of stream first + j.  The lanes are independent, so
+ * the inner loop vectorizes for 4 or 8 of them.  Nothing is drawn
+ * if the lanes run past the last stream.
+ * ------------------------------------------------------------------
+ */
+{
+  long long x[RNG_STREAMS];
+  long long t;
+  int       i;
+  int       j;
+  int       l;
+
+  rng = CONTEXT(rng);
+  if (first < 0 || lanes <= 0 || first + lanes > STREAMS)
+    return;
+  if ((rng->initialized == 0) && (first + lanes > 1)) /* as SelectStream */
+    PlantSeedsCtx(rng, DEFAULT);
+  if (rng->generator == RNG_XOSHIRO256) {
+    for (i = 0; i < n; i++, out += lanes)
+      for (j = 0; j < lanes; j++)
+        out[j] = XOSHIRO_DOUBLE(rng->xoshiro[first + j]);
+    return;
+  }
+  for (j = 0; j < lanes; j++)
+    x[j] = rng->seed[first + j];
+  for (i = 0; i < n; i++, out += lanes) {
+    for (j = 0; j + 4 <= lanes; j += 4)    /* fixed width, so it vectorizes */
+      for (l = j; l < j + 4; l++) {
+        x[l] = NEXT_SEED(x[l], t);
+        out[l] = (double) x[l] / MODULUS;
+      }
+    for (; j < lanes; j++) {
+      x[j] = NEXT_SEED(x[j], t);
+      out[j] = (double) x[j] / MODULUS;
+    }
+  }
+  for (j = 0; j < lanes; j++)
+    rng->seed[first + j] = (long) x[j];
+}
+
+
+   int SkipAhead(RngState *rng, long k)
+/* ------------------------------------------------------------------
+ * Use this function to advance the current stream by k calls to
+ * Random() in O(log k) steps, by multiplying its state by
+ * MULTIPLIER^k mod MODULUS.  k may be negative to step back.
+ * Returns -1, leaving the stream alone, for generators other than
+ * the Lehmer one.
+ * ------------------------------------------------------------------
+ */
+{
+  long long a = MULTIPLIER;                /* MULTIPLIER^(2^i)          */
+  long long x;
+
+  rng = CONTEXT(rng);
+  if (rng->generator != RNG_LEHMER)
+    return -1;
+  x = rng->seed[rng->stream];
+  k %= MODULUS - 1;                        /* the period of every stream */
+  if (k < 0)
+    k += MODULUS - 1;
+  while (k > 0) {
+    if (k & 1)
+      x = x * a % MODULUS;                 /* both below 2^31, no overflow */
+    a = a * a % MODULUS;
+    k >>= 1;
+  }
+  rng->seed[rng->stream] = (long) x;
+  return 0;
+}
+
+
+/* The original single-context API works on the global streams */
+
+   double Random(void)
+{
+  return RandomCtx(&global);
+}
+
+   void PlantSeeds(long x)
+{
+  PlantSeedsCtx(&global, x);
+}
+
+   void PutSeed(long x)
+{
+  PutSeedCtx(&global, x);
+}
+
+   void GetSeed(long *x)
+{
+  GetSeedCtx(&global, x);
+}
+
+   int GetStream(void)
+{
+  return GetStreamCtx(&global);
+}
+
+   void SelectStream(int index)
+{
+  SelectStreamCtx(&global, index);
+}
+
+   int SelectGenerator(int generator)
+{
+  return SelectGeneratorCtx(&global, generator);
 }
 
 
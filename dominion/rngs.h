@@ -9,11 +9,64 @@
 #if !defined( _RNGS_ )
 #define _RNGS_
 
+#define RNG_STREAMS 256
+
+/* Generators a context can run.  The Park-Miller Lehmer generator
+   (period 2^31 - 2) reproduces every existing seed; xoshiro256** is
+   faster per value, has period 2^256 - 1, and passes the statistical
+   test suites the Lehmer generator fails.  Build with
+   -DRNG_DEFAULT_GENERATOR=RNG_XOSHIRO256 to make it the default, or
+   pick one per context at run time with SelectGeneratorCtx */
+#define RNG_LEHMER     0
+#define RNG_XOSHIRO256 1
+
+#ifndef RNG_DEFAULT_GENERATOR
+#define RNG_DEFAULT_GENERATOR RNG_LEHMER
+#endif
+
+/* State of all the streams.  Each context is independent of the others
+   and of the global streams, so games holding their own context can be
+   interleaved or run on separate threads.  A NULL context stands for the
+   global streams the functions without Ctx use */
+typedef struct rngState {
+  long seed[RNG_STREAMS];     /* Lehmer state, or last seed put for xoshiro */
+  int  stream;
+  int  initialized;
+  int  generator;             /* RNG_LEHMER or RNG_XOSHIRO256 */
+  unsigned long long xoshiro[RNG_STREAMS][4];
+} RngState;
+
+/* Where one stream is, for either generator, see GetPositionCtx */
+typedef struct rngPosition {
+  int                stream;
+  long               seed;
+  unsigned long long xoshiro[4];
+} RngPosition;
+
+void   InitRngState(RngState *rng);
+int    SelectGeneratorCtx(RngState *rng, int generator);
+int    GetGeneratorCtx(RngState *rng);
+void   GetPositionCtx(RngState *rng, RngPosition *position);
+void   SetPositionCtx(RngState *rng, RngPosition *position);
+double RandomCtx(RngState *rng);
+void   PlantSeedsCtx(RngState *rng, long x);
+void   GetSeedCtx(RngState *rng, long *x);
+void   PutSeedCtx(RngState *rng, long x);
+void   SelectStreamCtx(RngState *rng, int index);
+int    GetStreamCtx(RngState *rng);
+int    SkipAhead(RngState *rng, long k);
+int    RandomInt(RngState *rng, int n);
+int    RandomIntLegacy(RngState *rng, int n);
+void   RandomFill(RngState *rng, double *out, int n);
+void   RandomFillStreams(RngState *rng, int first, int lanes, double *out, int n);
+
 double Random(void);
 void   PlantSeeds(long x);
 void   GetSeed(long *x);
 void   PutSeed(long x);
 void   SelectStream(int index);
+int    GetStream(void);
+int    SelectGenerator(int generator);
 void   TestRandom(void);
 
 #endif
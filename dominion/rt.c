@@ -1,27 +1,271 @@
+#define _POSIX_C_SOURCE 200112L
+#include "dominion.h"
 #include "rngs.h"
 #include <stdio.h>
-#include <stdlib.h> 
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
 
-int main(int argc, char** argv) {
-  if (argc < 3) {
-    printf ("Not enough inputs:  seed target\n");
+/* Seed search.  The search space is split into blocks handed out to the
+   worker threads in order, so the lowest hit is known once every block
+   below it is done.
+
+   rt value <seed> <target> [threads] [checkpoint]
+     first call n at which floor(Random() * 1000000000) == target on a
+     stream seeded with seed.  Each block of the period starts from a
+     SkipAhead jump, not by replaying the calls before it
+   rt opening <players> <coppers> <first> <last> [threads] [checkpoint]
+     lowest initializeGame seed in first..last at which player 0 opens
+     with that many coppers in hand (5 for a 5/2 opening)
+
+   Progress and throughput go to stderr every second.  Given a checkpoint
+   file the search saves how far it got and, run again with the same
+   arguments, resumes from there */
+
+#define MODULUS 2147483647
+#define VALUE_RANGE 1000000000
+#define VALUE_BLOCK (1L << 22) /* calls per block */
+#define SEED_BLOCK 256         /* seeds per block */
+#define FILL 4096
+
+struct search {
+  int opening;          /* 1 for an opening search, 0 for a value search */
+  long seed;            /* value search */
+  long target;
+  int players;          /* opening search */
+  int coppers;
+  long first;           /* search first .. first + count - 1 */
+  long count;
+  long block;
+  long blocks;
+  const char *checkpoint;
+
+  pthread_mutex_t lock; /* guards everything below */
+  long next;            /* next block to hand out */
+  char *finished;       /* per block */
+  long watermark;       /* every block below is finished */
+  long searched;        /* indexes searched since start */
+  long best;            /* lowest hit so far, -1 for none */
+  int running;          /* worker threads still going */
+};
+
+//lowest call in block b giving the target value, -1 if none
+long searchValues(struct search *s, long b) {
+  long from = s->first + b * s->block;
+  long n = s->first + s->count - from;
+  long i, j, chunk;
+  double draws[FILL];
+  RngState rng;
+
+  if (n > s->block)
+    n = s->block;
+  SelectGeneratorCtx(&rng, RNG_LEHMER); /* the one SkipAhead can jump */
+  PutSeedCtx(&rng, s->seed);
+  SkipAhead(&rng, from - 1);
+  for (i = 0; i < n; i += chunk) {
+    chunk = (n - i < FILL) ? n - i : FILL;
+    RandomFill(&rng, draws, chunk);
+    for (j = 0; j < chunk; j++)
+      if ((long)(draws[j] * VALUE_RANGE) == s->target)
+	return from + i + j;
   }
+  return -1;
+}
 
-  SelectStream(1);
-  PutSeed((long)atoi(argv[1]));
-  
-  int done = 0;
-  int c = 1000000000;
-  
-  while (!done) {
-    c = floor(Random() * 1000000000);
-    //    if (c % 100000 == 0) {
-    //      printf ("c = %d\n", c);
-    //    }
-    if (c == atoi(argv[2])) {
-      printf ("Found the bug!\n");
-      done = 1;
+//lowest seed in block b giving the opening, -1 if none
+long searchSeeds(struct search *s, long b) {
+  long from = s->first + b * s->block;
+  long n = s->first + s->count - from;
+  long i;
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+  RngState rng;
+  struct gameState G;
+
+  if (n > s->block)
+    n = s->block;
+  InitRngState(&rng);
+  for (i = 0; i < n; i++) {
+    initializeGameWithRng(s->players, k, from + i, &rng, &G);
+    if (G.pileCardCount[0][hand_pile][copper] == s->coppers)
+      return from + i;
+  }
+  return -1;
+}
+
+void* worker(void *arg) {
+  struct search *s = arg;
+  long b, hit;
+
+  for (;;) {
+    pthread_mutex_lock(&s->lock);
+    b = s->next;
+    //blocks past a hit cannot hold a lower one
+    if (b >= s->blocks || (s->best >= 0 && s->first + b * s->block > s->best)) {
+      s->running--;
+      pthread_mutex_unlock(&s->lock);
+      return NULL;
     }
+    s->next++;
+    pthread_mutex_unlock(&s->lock);
+
+    hit = s->opening ? searchSeeds(s, b) : searchValues(s, b);
+
+    pthread_mutex_lock(&s->lock);
+    if (hit >= 0 && (s->best < 0 || hit < s->best))
+      s->best = hit;
+    s->finished[b] = 1;
+    s->searched += (b == s->blocks - 1) ? s->count - b * s->block : s->block;
+    while (s->watermark < s->blocks && s->finished[s->watermark])
+      s->watermark++;
+    pthread_mutex_unlock(&s->lock);
   }
 }
 
+//arguments, then how far the search got
+void saveCheckpoint(struct search *s) {
+  char tmp[1024];
+  FILE *f;
+
+  if (s->checkpoint == NULL)
+    return;
+  snprintf(tmp, sizeof(tmp), "%s.tmp", s->checkpoint);
+  f = fopen(tmp, "w");
+  if (f == NULL)
+    return;
+  fprintf(f, "%d %ld %ld %d %d %ld %ld %ld %ld\n", s->opening, s->seed,
+	  s->target, s->players, s->coppers, s->first, s->count, s->watermark,
+	  s->best);
+  fclose(f);
+  rename(tmp, s->checkpoint);
+}
+
+//resume from the checkpoint if it was saved by the same search
+void loadCheckpoint(struct search *s) {
+  struct search saved;
+  FILE *f;
+  long b;
+
+  if (s->checkpoint == NULL || (f = fopen(s->checkpoint, "r")) == NULL)
+    return;
+  if (fscanf(f, "%d %ld %ld %d %d %ld %ld %ld %ld", &saved.opening,
+	     &saved.seed, &saved.target, &saved.players, &saved.coppers,
+	     &saved.first, &saved.count, &saved.watermark, &saved.best) == 9
+      && saved.opening == s->opening && saved.seed == s->seed
+      && saved.target == s->target && saved.players == s->players
+      && saved.coppers == s->coppers && saved.first == s->first
+      && saved.count == s->count
+      && saved.watermark >= 0 && saved.watermark <= s->blocks) {
+    for (b = 0; b < saved.watermark; b++)
+      s->finished[b] = 1;
+    s->next = s->watermark = saved.watermark;
+    s->best = saved.best;
+    fprintf(stderr, "Resuming at %.1f%%\n", 100.0 * s->watermark / s->blocks);
+  }
+  fclose(f);
+}
+
+double now() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int usage() {
+  printf ("Usage: rt value <seed> <target> [threads] [checkpoint]\n");
+  printf ("       rt opening <players> <coppers> <first> <last> [threads] [checkpoint]\n");
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  struct search s;
+  struct timespec tick = {0, 100000000};
+  pthread_t *threads;
+  int threadCount = 4;
+  int i, ticks, running, args;
+  long watermark, searched;
+  double start;
+
+  memset(&s, 0, sizeof(s));
+  if (argc >= 4 && strcmp(argv[1], "value") == 0) {
+    s.seed = atol(argv[2]);
+    s.target = atol(argv[3]);
+    s.first = 1;
+    s.count = MODULUS - 1; /* the whole period */
+    s.block = VALUE_BLOCK;
+    args = 4;
+    if (s.seed < 1 || s.target < 0 || s.target >= VALUE_RANGE)
+      return usage();
+  }
+  else if (argc >= 6 && strcmp(argv[1], "opening") == 0) {
+    s.opening = 1;
+    s.players = atoi(argv[2]);
+    s.coppers = atoi(argv[3]);
+    s.first = atol(argv[4]);
+    s.count = atol(argv[5]) - s.first + 1;
+    s.block = SEED_BLOCK;
+    args = 6;
+    if (s.players < 2 || s.players > MAX_PLAYERS || s.first < 1 || s.count < 1)
+      return usage();
+  }
+  else
+    return usage();
+  if (argc > args)
+    threadCount = atoi(argv[args]);
+  if (argc > args + 1)
+    s.checkpoint = argv[args + 1];
+  if (threadCount < 1)
+    return usage();
+
+  s.blocks = (s.count + s.block - 1) / s.block;
+  s.finished = calloc(s.blocks, 1);
+  threads = malloc(sizeof(pthread_t) * threadCount);
+  if (s.finished == NULL || threads == NULL)
+    return 1;
+  s.best = -1;
+  pthread_mutex_init(&s.lock, NULL);
+  loadCheckpoint(&s);
+
+  start = now();
+  s.running = threadCount;
+  for (i = 0; i < threadCount; i++)
+    pthread_create(&threads[i], NULL, worker, &s);
+
+  for (ticks = 1; ; ticks++) {
+    nanosleep(&tick, NULL);
+    pthread_mutex_lock(&s.lock);
+    running = s.running;
+    watermark = s.watermark;
+    searched = s.searched;
+    pthread_mutex_unlock(&s.lock);
+    if (running == 0)
+      break;
+    if (ticks % 10 == 0) {
+      pthread_mutex_lock(&s.lock);
+      saveCheckpoint(&s);
+      pthread_mutex_unlock(&s.lock);
+      fprintf(stderr, "%5.1f%% searched, %.2f M %s/s\n",
+	      100.0 * watermark / s.blocks, searched / (now() - start) / 1e6,
+	      s.opening ? "seeds" : "calls");
+    }
+  }
+  fprintf(stderr, "%.2f M %s/s\n", searched / (now() - start) / 1e6,
+	  s.opening ? "seeds" : "calls");
+
+  for (i = 0; i < threadCount; i++)
+    pthread_join(threads[i], NULL);
+  saveCheckpoint(&s);
+
+  if (s.best < 0)
+    printf ("Not found\n");
+  else if (s.opening)
+    printf ("Found seed %ld\n", s.best);
+  else
+    printf ("Found the bug! Call %ld\n", s.best);
+
+  free(threads);
+  free(s.finished);
+  return 0;
+}
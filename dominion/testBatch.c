@@ -0,0 +1,143 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "dominion_batch.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+#define LANES 37
+
+//reference score: hand + deck + discard, gardens 1 VP per 10 cards
+int referenceScore(int player, struct gameState *state) {
+  int total = state->handCount[player] + state->deckCount[player]
+    + state->discardCount[player];
+
+  return -fullDeckCount(player, curse, state)
+    + fullDeckCount(player, estate, state)
+    + 3 * fullDeckCount(player, duchy, state)
+    + 6 * fullDeckCount(player, province, state)
+    + fullDeckCount(player, great_hall, state)
+    + (total / 10) * fullDeckCount(player, gardens, state);
+}
+
+int main () {
+
+  int i, lane, turn, p, mark;
+  int bonus[LANES], result[LANES], pos[LANES], over[LANES], score[LANES];
+
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+
+  struct gameState G[LANES], S[LANES];
+  static RngState rngG[LANES], rngS[LANES];
+  struct gameBatch *batch;
+  struct moveJournal *journal;
+
+  printf ("Testing gameBatch.\n");
+
+  batch = newGameBatch(LANES);
+  assert(batch != NULL);
+  assert(newGameBatch(0) == NULL);
+
+  //each copy shuffles from its own copy of the streams
+  for (lane = 0; lane < LANES; lane++) {
+    InitRngState(&rngG[lane]);
+    assert(initializeGameWithRng(2 + lane % 3, k, lane + 1, &rngG[lane], &G[lane]) == 0);
+    memcpy(&S[lane], &G[lane], sizeof(struct gameState));
+    memcpy(&rngS[lane], &rngG[lane], sizeof(RngState));
+    S[lane].rng = &rngS[lane];
+  }
+
+  printf ("RANDOM TESTS.\n");
+
+  SelectStream(2);
+  PutSeed(5);
+
+  //step every lane with the batch and a scalar copy with the plain API
+  for (turn = 0; turn < 60; turn++) {
+    for (lane = 0; lane < LANES; lane++) {
+      loadBatchLane(batch, lane, &G[lane]);
+      bonus[lane] = floor(Random() * 4);
+      pos[lane] = floor(Random() * (treasure_map + 2)) - 1;
+      if (pos[lane] == gardens || pos[lane] == great_hall)
+	pos[lane] = province;
+    }
+
+    batchUpdateCoins(batch, bonus);
+    batchBuyCard(batch, pos, result);
+    batchIsGameOver(batch, over);
+
+    for (lane = 0; lane < LANES; lane++) {
+      updateCoins(S[lane].whoseTurn, &S[lane], bonus[lane]);
+      assert(batch->coins[lane] + (result[lane] == 0 ? getCost(pos[lane]) : 0)
+	     == S[lane].coins);
+      if (pos[lane] >= 0) {
+	assert(result[lane] == buyCard(pos[lane], &S[lane]));
+      } else {
+	assert(result[lane] == -1);
+      }
+      assert(over[lane] == isGameOver(&S[lane]));
+
+      storeBatchLane(batch, lane, &G[lane]);
+      assert(G[lane].coins == S[lane].coins);
+      assert(G[lane].bonusCoins == S[lane].bonusCoins);
+      assert(G[lane].numBuys == S[lane].numBuys);
+      assert(G[lane].phase == S[lane].phase);
+      assert(memcmp(G[lane].supplyCount, S[lane].supplyCount, sizeof(S[lane].supplyCount)) == 0);
+      assert(G[lane].discardCount[G[lane].whoseTurn] == S[lane].discardCount[S[lane].whoseTurn]);
+      assert(checkGameState(&G[lane]) == 0);
+    }
+
+    for (p = 0; p < MAX_PLAYERS; p++) {
+      batchScoreFor(batch, p, score);
+      for (lane = 0; lane < LANES; lane++) {
+	if (p < G[lane].numPlayers)
+	  assert(score[lane] == referenceScore(p, &G[lane]));
+      }
+    }
+
+    //both copies must draw the same shuffles
+    for (lane = 0; lane < LANES; lane++) {
+      endTurn(&G[lane]);
+      endTurn(&S[lane]);
+      for (i = 0; i < G[lane].numPlayers; i++)
+	assert(memcmp(G[lane].fullCardCount[i], S[lane].fullCardCount[i],
+		      sizeof(S[lane].fullCardCount[i])) == 0);
+    }
+  }
+
+  //a store is undone with everything else the journal recorded
+  journal = newJournal();
+  assert(journal != NULL);
+  for (lane = 0; lane < LANES; lane++) {
+    memcpy(&S[lane], &G[lane], sizeof(struct gameState));
+    G[lane].journal = journal;
+    loadBatchLane(batch, lane, &G[lane]);
+    bonus[lane] = 1 + lane % 3;
+    pos[lane] = silver;
+  }
+  batchUpdateCoins(batch, bonus);
+  batchBuyCard(batch, pos, result);
+  for (lane = 0; lane < LANES; lane++) {
+    clearJournal(journal);
+    mark = markJournal(&G[lane]);
+    storeBatchLane(batch, lane, &G[lane]);
+    assert(undoJournal(mark, &G[lane]) == 0);
+    G[lane].journal = NULL;
+    G[lane].dirtyPiles = S[lane].dirtyPiles;
+    assert(memcmp(&G[lane], &S[lane], sizeof(struct gameState)) == 0);
+  }
+  freeJournal(journal);
+
+  freeGameBatch(batch);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
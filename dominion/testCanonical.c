@@ -0,0 +1,104 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//swap two live cards of a pile through the engine primitives
+void swapCards(int i, int j, int pile, int player, struct gameState *state) {
+  int *cards = (pile == hand_pile) ? state->hand[player]
+    : (pile == deck_pile) ? state->deck[player] : state->discard[player];
+  int card = cards[i];
+
+  setPileCard(i, cards[j], pile, player, state);
+  setPileCard(j, card, pile, player, state);
+}
+
+int main () {
+
+  int n, move;
+  unsigned long long key;
+  struct gameState G, H;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+
+  printf ("Testing canonicalKey.\n");
+
+  assert(initializeGame(2, k, 9, &G) == 0);
+  assert(G.deckKnown[0] == 0 && G.deckKnown[1] == 0);
+  gainCard(silver, &G, 0, 0);
+  gainCard(gold, &G, 0, 0);
+
+  //hand and discard order do not matter
+  memcpy(&H, &G, sizeof(struct gameState));
+  swapCards(0, 4, hand_pile, 0, &H);
+  swapCards(0, 1, discard_pile, 0, &H);
+  assert(stateHash(&G) != stateHash(&H));
+  assert(canonicalKey(&G) == canonicalKey(&H));
+
+  //nor does the order of a shuffled deck
+  swapCards(0, 4, deck_pile, 1, &H);
+  assert(canonicalKey(&G) == canonicalKey(&H));
+
+  //cards put on top of a deck are known, in order
+  gainCard(gold, &G, 1, 1);
+  gainCard(silver, &G, 1, 1);
+  gainCard(silver, &H, 1, 1);
+  gainCard(gold, &H, 1, 1);
+  assert(G.deckKnown[1] == 2 && H.deckKnown[1] == 2);
+  assert(canonicalKey(&G) != canonicalKey(&H));
+  swapCards(H.deckCount[1] - 1, H.deckCount[1] - 2, deck_pile, 1, &H);
+  assert(canonicalKey(&G) == canonicalKey(&H));
+
+  //drawing uncovers known cards, shuffling forgets them
+  drawCard(1, &G);
+  assert(G.deckKnown[1] == 1);
+  shuffle(1, &G);
+  assert(G.deckKnown[1] == 0);
+
+  //canonical states are equal where the key says so
+  key = canonicalKey(&H);
+  swapCards(1, 3, hand_pile, 0, &H);
+  canonicalizeState(&H);
+  assert(canonicalKey(&H) == key);
+  assert(checkGameState(&H) == 0);
+  memcpy(&G, &H, sizeof(struct gameState));
+  swapCards(0, 2, hand_pile, 0, &G);
+  swapCards(0, 1, discard_pile, 0, &G);
+  canonicalizeState(&G);
+  assert(stateHash(&G) == stateHash(&H));
+
+  printf ("RANDOM TESTS.\n");
+
+  for (n = 0; n < 20; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    SelectStream(2);
+    PutSeed(n + 1);
+
+    for (move = 0; move < 200 && !isGameOver(&G); move++) {
+      if (Random() < 0.25)
+	randomGain(&G);
+      else
+	randomMove(&G);
+
+      //canonicalizing keeps the key and the cached fields
+      memcpy(&H, &G, sizeof(struct gameState));
+      canonicalizeState(&H);
+      assert(canonicalKey(&H) == canonicalKey(&G));
+      assert(checkGameState(&H) == 0);
+      assert(checkGameState(&G) == 0);
+    }
+  }
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//treasure in a hand, counted card by card
+int handTreasure(int player, struct gameState *G) {
+  int i, coins = 0;
+
+  for (i = 0; i < G->handCount[player]; i++)
+    if (VALID_CARD(G->hand[player][i]))
+      coins += cardTable[G->hand[player][i]].coins;
+  return coins;
+}
+
+//put card at the front of the current player's hand
+void giveCard(int card, struct gameState *G) {
+  int player = whoseTurn(G);
+
+  gainCard(card, G, 2, player);
+  setPileCard(G->handCount[player] - 1, G->hand[player][0], hand_pile, player, G);
+  setPileCard(0, card, hand_pile, player, G);
+}
+
+int main () {
+
+  int i, n, r, spent, coins, card;
+  struct gameState G;
+
+  int k[10] = {baron, feast, cutpurse, mine, smithy,
+	       minion, steward, salvager, embargo, tribute};
+
+  printf ("Testing coins.\n");
+
+  //action coins stay with the treasure drawn after them
+  assert(initializeGame(2, k, 1, &G) == 0);
+  assert(G.coins == handTreasure(0, &G) && G.bonusCoins == 0);
+  giveCard(baron, &G);
+  setPileCard(1, estate, hand_pile, 0, &G);
+  assert(playCard(0, 1, 0, 0, &G) == 0);
+  assert(G.bonusCoins == 4 && G.coins == handTreasure(0, &G) + 4);
+
+  //feast pays for what it gains, the coins in hand are untouched
+  endTurn(&G);
+  giveCard(feast, &G);
+  coins = G.coins;
+  assert(playCard(0, duchy, 0, 0, &G) == 0);
+  assert(G.coins == coins && G.bonusCoins == 0);
+  assert(G.discard[1][G.discardCount[1] - 1] == duchy);
+  G.numActions = 1;
+  assert(playCard(0, province, 0, 0, &G) == -1);
+  assert(G.coins == coins);
+
+  //cutpurse adds 2 to the coins in hand
+  endTurn(&G);
+  giveCard(cutpurse, &G);
+  coins = G.coins;
+  assert(playCard(0, 0, 0, 0, &G) == 0);
+  assert(G.coins == coins + 2 && G.bonusCoins == 2);
+
+  printf ("RANDOM TESTS.\n");
+
+  SelectStream(2);
+  PutSeed(5);
+  for (n = 0; n < 50; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    for (i = 0; i < 200 && !isGameOver(&G); i++) {
+      spent = 0;
+      for (r = 0; r < 3; r++)
+	randomPlay(&G);
+      card = randomBuy(&G);
+      if (card >= 0)
+	spent += getCost(card);
+      //coins are the treasure in hand plus action coins, less what was spent
+      assert(G.coins == handTreasure(whoseTurn(&G), &G) + G.bonusCoins - spent);
+      assert(G.handCoins[whoseTurn(&G)] == handTreasure(whoseTurn(&G), &G));
+      assert(checkGameState(&G) == 0);
+      endTurn(&G);
+      assert(G.coins == handTreasure(whoseTurn(&G), &G) && G.bonusCoins == 0);
+    }
+  }
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "dominion_compact.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//compare the live parts of two states
+void assertSameState(struct gameState *a, struct gameState *b) {
+  int p;
+
+  assert(a->numPlayers == b->numPlayers);
+  assert(memcmp(a->supplyCount, b->supplyCount, sizeof(a->supplyCount)) == 0);
+  assert(a->whoseTurn == b->whoseTurn);
+  assert(a->coins == b->coins && a->bonusCoins == b->bonusCoins);
+  assert(a->playedCardCount == b->playedCardCount);
+  assert(memcmp(a->playedCards, b->playedCards, sizeof(int) * a->playedCardCount) == 0);
+  for (p = 0; p < a->numPlayers; p++) {
+    assert(a->handCount[p] == b->handCount[p]);
+    assert(a->deckCount[p] == b->deckCount[p]);
+    assert(a->discardCount[p] == b->discardCount[p]);
+    assert(a->deckKnown[p] == b->deckKnown[p]);
+    assert(memcmp(a->hand[p], b->hand[p], sizeof(int) * a->handCount[p]) == 0);
+    assert(memcmp(a->deck[p], b->deck[p], sizeof(int) * a->deckCount[p]) == 0);
+    assert(memcmp(a->discard[p], b->discard[p], sizeof(int) * a->discardCount[p]) == 0);
+  }
+}
+
+int main () {
+
+  int n, p, card;
+  RngPosition before, after;
+  RngState a, b;
+
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+
+  struct gameState G, H, U;
+  struct compactGameState C;
+
+  printf ("Testing compact gameState.\n");
+  printf ("sizeof(struct gameState) = %lu, sizeof(struct compactGameState) = %lu\n",
+	  (unsigned long)sizeof(struct gameState),
+	  (unsigned long)sizeof(struct compactGameState));
+  assert(sizeof(struct compactGameState) * 3 < sizeof(struct gameState));
+
+  //each encoding shuffles from its own copy of the streams
+  InitRngState(&a);
+  assert(initializeGameWithRng(2, k, 7, &a, &G) == 0);
+  memcpy(&b, &a, sizeof(RngState));
+  assert(packGameState(&G, &C) == 0);
+  C.rng = &b;
+  assert(compactNumHandCards(&C) == numHandCards(&G));
+  assert(compactHandCard(0, &C) == handCard(0, &G));
+  for (card = curse; card <= treasure_map; card++) {
+    assert(compactFullDeckCount(0, card, &C) == fullDeckCount(0, card, &G));
+    assert(compactSupplyCount(card, &C) == supplyCount(card, &G));
+  }
+  unpackGameState(&C, &U);
+  assertSameState(&G, &U);
+
+  //action coins survive the round trip whatever the target held before
+  updateCoins(G.whoseTurn, &G, 3);
+  assert(packGameState(&G, &C) == 0);
+  C.rng = &b;
+  U.bonusCoins = 99;
+  U.dirtyPiles = 0;
+  unpackGameState(&C, &U);
+  assertSameState(&G, &U);
+  assert(U.coins == U.handCoins[U.whoseTurn] + U.bonusCoins);
+  assert(U.dirtyPiles == ~0u);
+
+  printf ("RANDOM TESTS.\n");
+
+  SelectStream(2);
+  PutSeed(3);
+
+  //run the same random sequence of pile operations on both encodings
+  for (n = 0; n < 2000; n++) {
+    p = floor(Random() * 2);
+    card = floor(Random() * 4);
+
+    if (card == 0 && G.handCount[p] > 0) {
+      discardCard(0, p, &G, n % 2);
+      compactDiscardCard(0, p, &C, n % 2);
+    } else if (card == 1) {
+      gainCard(copper + n % 3, &G, n % 3, p);
+      compactGainCard(copper + n % 3, &C, n % 3, p);
+    } else if (G.handCount[p] < MAX_HAND - 1) {
+      drawCard(p, &G);
+      compactDrawCard(p, &C);
+    }
+
+    if (G.playedCardCount > MAX_DECK / 2) {
+      G.playedCardCount = 0;
+      C.playedCardCount = 0;
+    }
+
+    unpackGameState(&C, &U);
+    assertSameState(&G, &U);
+    assert(checkGameState(&G) == 0);
+    assert(memcmp(U.fullCardCount, G.fullCardCount, sizeof(G.fullCardCount)) == 0);
+  }
+
+  //a packed game shuffles from its own RngState, common random numbers
+  //included, and leaves the global streams alone
+  InitRngState(&a);
+  InitRngState(&b);
+  assert(initializeGameCrn(2, k, 5, &a, &G) == 0);
+  assert(initializeGameCrn(2, k, 5, &b, &H) == 0);
+  assert(packGameState(&H, &C) == 0);
+  assert(C.rng == &b && C.crnSeed == G.crnSeed);
+  for (n = 0; n < 20; n++) {
+    p = n % 2;
+    GetPositionCtx(NULL, &before);
+    assert(shuffle(p, &G) == 0);
+    assert(compactShuffle(p, &C) == 0);
+    GetPositionCtx(NULL, &after);
+    assert(after.seed == before.seed
+	   && memcmp(after.xoshiro, before.xoshiro, sizeof(after.xoshiro)) == 0);
+    unpackGameState(&C, &U);
+    assert(U.shuffles[p] == G.shuffles[p]);
+    assert(memcmp(U.deck[p], G.deck[p], sizeof(int) * G.deckCount[p]) == 0);
+    gainCard(silver + n % 2, &G, 1, p);
+    compactGainCard(silver + n % 2, &C, 1, p);
+  }
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
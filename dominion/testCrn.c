@@ -0,0 +1,161 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+#define SEEDS 400
+#define MAX_TURNS 200
+
+//one turn of big money, playing any smithy in hand and buying up to
+//smithies of them
+void botTurn(int smithies, int bought[MAX_PLAYERS], struct gameState *G) {
+  int i, player = whoseTurn(G);
+
+  for (i = 0; i < numHandCards(G); i++)
+    if (handCard(i, G) == smithy) {
+      playCard(i, -1, -1, -1, G);
+      break;
+    }
+  if (G->coins >= 8)
+    buyCard(province, G);
+  else if (G->coins >= 6)
+    buyCard(gold, G);
+  else if (G->coins >= 4 && bought[player] < smithies) {
+    buyCard(smithy, G);
+    bought[player]++;
+  }
+  else if (G->coins >= 3)
+    buyCard(silver, G);
+  endTurn(G);
+}
+
+//score margin of player 0, buying up to smithies Smithies, over a player 1
+//playing plain big money
+int playGame(int crn, int seed, int smithies, int k[10]) {
+  int turn, bought[MAX_PLAYERS] = {0};
+  struct gameState G;
+  RngState rng;
+
+  InitRngState(&rng);
+  if (crn)
+    assert(initializeGameCrn(2, k, seed, &rng, &G) == 0);
+  else
+    assert(initializeGameWithRng(2, k, seed, &rng, &G) == 0);
+  for (turn = 0; turn < MAX_TURNS && !isGameOver(&G); turn++)
+    botTurn(whoseTurn(&G) == 0 ? smithies : 0, bought, &G);
+  assert(checkGameState(&G) == 0);
+  return scoreFor(0, &G) - scoreFor(1, &G);
+}
+
+int main () {
+
+  int i, n, seed, mark, crn, d;
+  int bought[MAX_PLAYERS];
+  double sum, sumSquares, variance[2];
+  struct gameState G, H;
+  struct moveJournal *journal;
+  RngState a, b;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+  int cards[12] = {copper, copper, copper, silver, silver, gold,
+		   estate, estate, duchy, province, smithy, village};
+
+  printf ("Testing common random numbers.\n");
+
+  assert(initializeGameCrn(2, k, 0, NULL, &G) == -1);
+  assert(initializeGameCrn(1, k, 1, NULL, &G) == -1);
+
+  printf ("RANDOM TESTS.\n");
+
+  for (seed = 1; seed <= 50; seed++) {
+    //the same seed deals the same openings
+    InitRngState(&a);
+    InitRngState(&b);
+    memset(&G, 0, sizeof(struct gameState));
+    memset(&H, 0, sizeof(struct gameState));
+    assert(initializeGameCrn(3, k, seed, &a, &G) == 0);
+    assert(initializeGameCrn(3, k, seed, &b, &H) == 0);
+    H.rng = G.rng;
+    assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+    assert(G.shuffles[0] == 1 && G.crnSeed == seed);
+
+    //other draws and other players' shuffles leave a player's shuffles alone
+    for (i = 0; i < 100; i++)
+      RandomCtx(&b);
+    H.rng = &b;
+    shuffle(1, &H);
+    shuffle(2, &H);
+    for (i = 0; i < 3; i++) {
+      setPileCount(0, deck_pile, 0, &G);
+      setPileCount(0, deck_pile, 0, &H);
+      for (n = 0; n < 12; n++) {
+	pushCard(cards[n], deck_pile, 0, &G);
+	pushCard(cards[n], deck_pile, 0, &H);
+      }
+      assert(shuffle(0, &G) == 0 && shuffle(0, &H) == 0);
+      for (n = 0; n < 12; n++) {
+	drawCard(0, &G);
+	drawCard(0, &H);
+      }
+      assert(memcmp(G.hand[0], H.hand[0], sizeof(int) * G.handCount[0]) == 0);
+      assert(GetStreamCtx(&a) == 1 && GetStreamCtx(&b) == 1);
+      setPileCount(0, hand_pile, 0, &G);
+      setPileCount(0, hand_pile, 0, &H);
+    }
+    assert(checkGameState(&G) == 0 && checkGameState(&H) == 0);
+  }
+
+  //undoing a shuffle undoes its index too, so replaying the turns deals the
+  //same cards even after stream 1 moved on
+  journal = newJournal();
+  assert(journal != NULL);
+  InitRngState(&a);
+  assert(initializeGameCrn(2, k, 7, &a, &G) == 0);
+  G.journal = journal;
+  mark = markJournal(&G);
+  memset(bought, 0, sizeof(bought));
+  for (n = 0; n < 30; n++)
+    botTurn(1, bought, &G);
+  memcpy(&H, &G, sizeof(struct gameState));
+  assert(undoJournal(mark, &G) == 0);
+  for (i = 0; i < 100; i++)
+    RandomCtx(&a);
+  memset(bought, 0, sizeof(bought));
+  for (n = 0; n < 30; n++)
+    botTurn(1, bought, &G);
+  assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+  G.journal = NULL;
+  freeJournal(journal);
+
+  //score margins of one smithy against none, seed by seed, vary less when
+  //both games deal the same shuffles
+  for (crn = 0; crn < 2; crn++) {
+    sum = sumSquares = 0;
+    for (seed = 1; seed <= SEEDS; seed++) {
+      d = playGame(crn, seed, 1, k) - playGame(crn, seed, 0, k);
+      sum += d;
+      sumSquares += (double)d * d;
+    }
+    variance[crn] = (sumSquares - sum * sum / SEEDS) / (SEEDS - 1);
+    if (NOISY_TEST)
+      printf ("%s: smithy gains %.2f VP, variance %.1f\n",
+	      crn ? "common random numbers" : "independent", sum / SEEDS,
+	      variance[crn]);
+  }
+#ifndef LAZY_SHUFFLE
+  //lazy decks key every card dealt on its own, which couples games less
+  assert(variance[1] < variance[0]);
+#endif
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
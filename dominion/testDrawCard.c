@@ -12,7 +12,10 @@ int checkDrawCard(int p, struct gameState *post) {
   struct gameState pre;
   memcpy (&pre, post, sizeof(struct gameState));
 
-  int r;
+  int r, card, drew = 1;
+#ifdef LAZY_SHUFFLE
+  int i, top;
+#endif
   //  printf ("drawCard PRE: p %d HC %d DeC %d DiC %d\n",
   //	  p, pre.handCount[p], pre.deckCount[p], pre.discardCount[p]);
     
@@ -21,7 +24,23 @@ int checkDrawCard(int p, struct gameState *post) {
   //printf ("drawCard POST: p %d HC %d DeC %d DiC %d\n",
   //      p, post->handCount[p], post->deckCount[p], post->discardCount[p]);
 
+  //which piles drawCard marks dirty is checked in testSnapshot
+  pre.dirtyPiles = post->dirtyPiles;
+
   if (pre.deckCount[p] > 0) {
+#ifdef LAZY_SHUFFLE
+    //an unseen top card is first swapped with one from anywhere in the deck
+    top = pre.deckCount[p] - 1;
+    if (pre.deckKnown[p] == 0) {
+      for (i = 0; i < top && post->deck[p][i] == pre.deck[p][i]; i++)
+	;
+      if (i < top) {
+	assert(post->deck[p][i] == pre.deck[p][top]);
+	pre.deck[p][i] = pre.deck[p][top];
+	pre.deck[p][top] = post->hand[p][post->handCount[p]-1];
+      }
+    }
+#endif
     pre.handCount[p]++;
     pre.hand[p][pre.handCount[p]-1] = pre.deck[p][pre.deckCount[p]-1];
     pre.deckCount[p]--;
@@ -32,10 +51,21 @@ int checkDrawCard(int p, struct gameState *post) {
     pre.handCount[p]++;
     pre.deckCount[p] = pre.discardCount[p]-1;
     pre.discardCount[p] = 0;
+    pre.shuffles[p]++;
+  } else {
+    drew = 0;
   }
 
   assert (r == 0);
 
+  //a treasure drawn on the player's own turn is coins to spend
+  card = pre.hand[p][pre.handCount[p]-1];
+  if (drew && p == pre.whoseTurn && VALID_CARD(card))
+    pre.coins += cardTable[card].coins;
+
+  //cached card counts must match a recount of the expected piles
+  syncGameState(&pre);
+  assert(checkGameState(post) == 0);
   assert(memcmp(&pre, post, sizeof(struct gameState)) == 0);
 }
 
@@ -47,6 +77,7 @@ int main () {
 	       remodel, smithy, village, baron, great_hall};
 
   struct gameState G;
+  static double noise[sizeof(struct gameState)];
 
   printf ("Testing drawCard.\n");
 
@@ -56,13 +87,19 @@ int main () {
   PutSeed(3);
 
   for (n = 0; n < 2000; n++) {
+    RandomFill(NULL, noise, sizeof(struct gameState));
     for (i = 0; i < sizeof(struct gameState); i++) {
-      ((char*)&G)[i] = floor(Random() * 256);
+      ((char*)&G)[i] = floor(noise[i] * 256);
     }
     p = floor(Random() * 2);
     G.deckCount[p] = floor(Random() * MAX_DECK);
     G.discardCount[p] = floor(Random() * MAX_DECK);
     G.handCount[p] = floor(Random() * MAX_HAND);
+    G.numPlayers = 2;
+    G.journal = NULL;
+    G.rng = NULL;
+    G.crnSeed = 0;
+    syncGameState(&G);
     checkDrawCard(p, &G);
   }
 
@@ -0,0 +1,194 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "dominion_flex.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//reference score: hand + deck + discard, gardens 1 VP per 10 cards
+int referenceScore(int player, struct gameState *state) {
+  int total = state->handCount[player] + state->deckCount[player]
+    + state->discardCount[player];
+
+  return -fullDeckCount(player, curse, state)
+    + fullDeckCount(player, estate, state)
+    + 3 * fullDeckCount(player, duchy, state)
+    + 6 * fullDeckCount(player, province, state)
+    + fullDeckCount(player, great_hall, state)
+    + (total / 10) * fullDeckCount(player, gardens, state);
+}
+
+//every live card, count and scalar of both states must agree
+void checkSame(struct flexGameState *F, struct gameState *G) {
+  int p, i, card;
+
+  assert(F->numPlayers == G->numPlayers);
+  assert(F->whoseTurn == G->whoseTurn);
+  assert(F->coins == G->coins && F->bonusCoins == G->bonusCoins);
+  assert(F->numBuys == G->numBuys);
+  assert(F->phase == G->phase);
+  //supply_t is narrower than int in SPLIT_LAYOUT
+  for (card = curse; card <= treasure_map; card++)
+    assert(F->supplyCount[card] == G->supplyCount[card]);
+  assert(F->playedCards.count == G->playedCardCount);
+  for (p = 0; p < G->numPlayers; p++) {
+    assert(F->players[p].hand.count == G->handCount[p]);
+    assert(F->players[p].deck.count == G->deckCount[p]);
+    assert(F->players[p].discard.count == G->discardCount[p]);
+    assert(F->players[p].deckKnown == G->deckKnown[p]);
+    assert(F->players[p].handCoins == G->handCoins[p]);
+    for (i = 0; i < G->handCount[p]; i++)
+      assert(pileCard(&F->players[p].hand, i) == G->hand[p][i]);
+    for (i = 0; i < G->deckCount[p]; i++)
+      assert(pileCard(&F->players[p].deck, i) == G->deck[p][i]);
+    for (i = 0; i < G->discardCount[p]; i++)
+      assert(pileCard(&F->players[p].discard, i) == G->discard[p][i]);
+    for (card = curse; card <= treasure_map; card++)
+      assert(flexFullDeckCount(p, card, F) == fullDeckCount(p, card, G));
+    assert(flexScoreFor(p, F) == referenceScore(p, G));
+  }
+}
+
+int main () {
+
+  int i, n, turn, card, r;
+  RngPosition before, after;
+  RngState a, b;
+  struct pile P;
+  struct flexGameState F;
+  struct gameState G, H;
+
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+
+  printf ("Testing flexGameState.\n");
+
+  //piles move from inline storage to the heap and keep their cards
+  initPile(&P);
+  for (i = 0; i < 5 * PILE_INLINE; i++)
+    assert(pushPile(&P, i % (treasure_map + 1)) == 0);
+  assert(P.heap != NULL && P.capacity >= 5 * PILE_INLINE);
+  for (i = 0; i < 5 * PILE_INLINE; i++)
+    assert(pileCard(&P, i) == i % (treasure_map + 1));
+  assert(pushPile(&P, treasure_map + 1) == -1);
+  assert(pileCard(&P, 5 * PILE_INLINE) == -1);
+  assert(removePileCard(&P, 0) == 0);
+  assert(pileCard(&P, 0) == (5 * PILE_INLINE - 1) % (treasure_map + 1));
+  freePile(&P);
+  assert(P.heap == NULL && P.count == 0 && popPile(&P) == -1);
+
+  //player limit is a run-time setting, up to what cardTable covers
+  assert(getMaxPlayers() == FLEX_MAX_PLAYERS);
+  assert(setMaxPlayers(1) == -1);
+  assert(setMaxPlayers(SUPPLY_PLAYERS + 1) == -1);
+  assert(initializeFlexGame(SUPPLY_PLAYERS + 1, k, 1, &F) == -1);
+  assert(setMaxPlayers(3) == 0);
+  assert(initializeFlexGame(4, k, 1, &F) == -1);
+  assert(setMaxPlayers(FLEX_MAX_PLAYERS) == 0);
+  assert(initializeFlexGame(5, k, 1, &F) == 0);
+  for (card = curse; card < adventurer; card++)
+    assert(flexSupplyCount(card, &F) == cardTable[card].supply[5]);
+  assert(flexSupplyCount(curse, &F) == 40 && flexSupplyCount(province, &F) == 15);
+  assert(flexSupplyCount(gardens, &F) == 12 && flexSupplyCount(smithy, &F) == 10);
+  assert(flexSupplyCount(minion, &F) == -1);
+  assert(flexToGameState(&F, &G) == -1);
+  freeFlexGame(&F);
+
+  printf ("RANDOM TESTS.\n");
+
+  //lockstep with the fixed-size engine
+  for (n = 2; n <= MAX_PLAYERS; n++) {
+    //each copy shuffles from its own copy of the streams
+    InitRngState(&a);
+    InitRngState(&b);
+    assert(initializeGameWithRng(n, k, n * 7, &a, &G) == 0);
+    assert(initializeFlexGameWithRng(n, k, n * 7, &b, &F) == 0);
+    checkSame(&F, &G);
+
+    SelectStream(2);
+    PutSeed(n);
+    for (turn = 0; turn < 80 && !isGameOver(&G); turn++) {
+      card = floor(Random() * (treasure_map + 1));
+      if (Random() < 0.3 && numHandCards(&G) > 0) {
+	r = Random() < 0.5;
+	i = floor(Random() * numHandCards(&G));
+	assert(flexDiscardCard(i, F.whoseTurn, &F, r) == 0);
+	discardCard(i, G.whoseTurn, &G, r);
+      }
+      if (turn % 5 == 0) {
+	assert(flexUpdateCoins(F.whoseTurn, &F, turn % 4) == 0);
+	updateCoins(G.whoseTurn, &G, turn % 4);
+      }
+      assert(flexBuyCard(card, &F) == buyCard(card, &G));
+      assert(flexGainCard(card, &F, turn % 3, F.whoseTurn) ==
+	     gainCard(card, &G, turn % 3, G.whoseTurn));
+      assert(flexIsGameOver(&F) == isGameOver(&G));
+      checkSame(&F, &G);
+
+      //both copies must draw the same shuffles
+      endTurn(&G);
+      flexEndTurn(&F);
+      checkSame(&F, &G);
+    }
+
+    //round trip through both representations
+    freeFlexGame(&F);
+    assert(gameStateToFlex(&G, &F) == 0);
+    checkSame(&F, &G);
+    memset(&H, 0, sizeof(struct gameState));
+    H.bonusCoins = 99;
+    assert(flexToGameState(&F, &H) == 0);
+    assert(checkGameState(&H) == 0);
+    checkSame(&F, &H);
+    assert(H.dirtyPiles == ~0u);
+    freeFlexGame(&F);
+  }
+
+  //a converted common random numbers game keeps drawing its shuffles from
+  //its own RngState, so no replay is needed and the global streams stay put
+  InitRngState(&a);
+  InitRngState(&b);
+  assert(initializeGameCrn(3, k, 11, &a, &G) == 0);
+  assert(initializeGameCrn(3, k, 11, &b, &H) == 0);
+  assert(gameStateToFlex(&H, &F) == 0);
+  assert(F.rng == &b && F.crnSeed == G.crnSeed);
+  GetPositionCtx(NULL, &before);
+  for (turn = 0; turn < 60 && !isGameOver(&G); turn++) {
+    card = turn % 3 ? silver : smithy;
+    assert(flexBuyCard(card, &F) == buyCard(card, &G));
+    endTurn(&G);
+    flexEndTurn(&F);
+    checkSame(&F, &G);
+  }
+  GetPositionCtx(NULL, &after);
+  assert(after.seed == before.seed
+	 && memcmp(after.xoshiro, before.xoshiro, sizeof(after.xoshiro)) == 0);
+  memset(&H, 0, sizeof(struct gameState));
+  assert(flexToGameState(&F, &H) == 0);
+  assert(H.rng == &b && memcmp(H.shuffles, G.shuffles, sizeof(G.shuffles)) == 0);
+  freeFlexGame(&F);
+
+  //six players play big money to the end, past MAX_PLAYERS
+  assert(initializeFlexGame(6, k, 3, &F) == 0);
+  assert(flexSupplyCount(province, &F) == 18);
+  for (turn = 0; turn < 2000 && !flexIsGameOver(&F); turn++) {
+    if (F.coins >= 8) flexBuyCard(province, &F);
+    else if (F.coins >= 6) flexBuyCard(gold, &F);
+    else if (F.coins >= 3) flexBuyCard(silver, &F);
+    flexEndTurn(&F);
+  }
+  assert(flexIsGameOver(&F));
+  for (n = 0; n < 6; n++)
+    printf ("Player %d: %d\n", n, flexScoreFor(n, &F));
+  freeFlexGame(&F);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//game over by a full scan of the supply
+int scanGameOver(struct gameState *G) {
+  int card, empty = 0;
+
+  for (card = curse; card <= treasure_map; card++)
+    if (G->supplyCount[card] == 0)
+      empty++;
+  return G->supplyCount[province] == 0 || empty >= 3;
+}
+
+int main () {
+
+  int i, n, mark;
+  struct gameState G;
+  struct moveJournal *journal;
+
+  int k[10] = {ambassador, baron, embargo, feast, mine,
+	       remodel, salvager, smithy, village, treasure_map};
+
+  printf ("Testing isGameOver.\n");
+
+  //treasure map is a supply pile like any other
+  assert(initializeGame(2, k, 1, &G) == 0);
+  assert(G.emptyPiles == 0 && !isGameOver(&G));
+  setSupplyCount(smithy, 0, &G);
+  setSupplyCount(village, 0, &G);
+  assert(G.emptyPiles == 2 && !isGameOver(&G));
+  setSupplyCount(treasure_map, 0, &G);
+  assert(G.emptyPiles == 3 && isGameOver(&G));
+  setSupplyCount(treasure_map, 1, &G);
+  assert(G.emptyPiles == 2 && !isGameOver(&G));
+
+  //a pile not in the game is not empty
+  assert(G.supplyCount[adventurer] == -1);
+  setSupplyCount(province, 0, &G);
+  assert(G.emptyPiles == 3 && isGameOver(&G));
+  assert(checkGameState(&G) == 0);
+
+  printf ("RANDOM TESTS.\n");
+
+  journal = newJournal();
+  assert(journal != NULL);
+  SelectStream(2);
+  PutSeed(11);
+  for (n = 0; n < 100; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    G.journal = journal;
+    clearJournal(journal);
+    mark = markJournal(&G);
+    for (i = 0; i < 500 && !isGameOver(&G); i++) {
+      randomTurn(&G);
+      assert(isGameOver(&G) == scanGameOver(&G));
+      assert(checkGameState(&G) == 0);
+      endTurn(&G);
+    }
+    assert(isGameOver(&G) == scanGameOver(&G));
+
+    //undo restores the count with the supply
+    assert(undoJournal(mark, &G) == 0);
+    assert(G.emptyPiles == 0 && !isGameOver(&G));
+    assert(checkGameState(&G) == 0);
+    G.journal = NULL;
+  }
+  freeJournal(journal);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+int main () {
+
+  int n, move, mark, supply;
+  unsigned long long before;
+  struct gameState G, H;
+  struct moveJournal *journal;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, ambassador, embargo};
+
+  printf ("Testing stateHash.\n");
+
+  //same position reached two ways hashes the same
+  assert(initializeGame(2, k, 4, &G) == 0);
+  memcpy(&H, &G, sizeof(struct gameState));
+  gainCard(silver, &G, 0, 0);
+  gainCard(gold, &G, 2, 1);
+  gainCard(gold, &H, 2, 1);
+  gainCard(silver, &H, 0, 0);
+  assert(stateHash(&G) == stateHash(&H));
+  before = stateHash(&G);
+  G.coins++;
+  assert(stateHash(&G) != before);
+  G.coins--;
+  setSupplyCount(curse, supplyCount(curse, &G), &G);
+  assert(stateHash(&G) == before);
+  setEmbargoTokens(curse, 1, &G);
+  assert(stateHash(&G) != before);
+  assert(setSupplyCount(treasure_map + 1, 0, &G) == -1);
+
+  //dead slots past the end of a pile do not count
+  G.hand[0][G.handCount[0]] = province;
+  H.hand[0][H.handCount[0]] = curse;
+  setEmbargoTokens(curse, 0, &G);
+  assert(stateHash(&G) == stateHash(&H));
+
+  //ambassador's write to the supply is hashed like any other; copper (4)
+  //passes the handler's copy check with five cards in hand
+  assert(initializeGame(3, k, 2, &G) == 0);
+  setPileCard(0, ambassador, hand_pile, 0, &G);
+  setPileCard(1, copper, hand_pile, 0, &G);
+  supply = supplyCount(copper, &G);
+  assert(playCard(0, 1, 1, 0, &G) == 0);
+  assert(supplyCount(copper, &G) == supply + 1 - 2);
+  memcpy(&H, &G, sizeof(struct gameState));
+  syncGameState(&H);
+  assert(H.hash == G.hash);
+
+  printf ("RANDOM TESTS.\n");
+
+  journal = newJournal();
+  assert(journal != NULL);
+
+  for (n = 0; n < 20; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    G.journal = journal;
+    clearJournal(journal);
+    SelectStream(2);
+    PutSeed(n + 1);
+
+    for (move = 0; move < 200 && !isGameOver(&G); move++) {
+      before = stateHash(&G);
+      mark = markJournal(&G);
+
+      randomMove(&G);
+
+      //incremental hash matches one computed from scratch
+      memcpy(&H, &G, sizeof(struct gameState));
+      syncGameState(&H);
+      assert(H.hash == G.hash && stateHash(&H) == stateHash(&G));
+
+      //undo brings the hash back with the state
+      if (Random() < 0.3) {
+	assert(undoJournal(mark, &G) == 0);
+	assert(stateHash(&G) == before);
+      }
+      clearJournal(journal);
+    }
+  }
+
+  freeJournal(journal);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "testHelpers.h"
+#include "dominion_helpers.h"
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+void assertSameLive(struct gameState *a, struct gameState *b) {
+  int p;
+
+  assert(a->numPlayers == b->numPlayers);
+  assert(memcmp(a->supplyCount, b->supplyCount, sizeof(a->supplyCount)) == 0);
+  assert(memcmp(a->embargoTokens, b->embargoTokens, sizeof(a->embargoTokens)) == 0);
+  assert(a->whoseTurn == b->whoseTurn && a->phase == b->phase);
+  assert(a->numActions == b->numActions && a->numBuys == b->numBuys);
+  assert(a->coins == b->coins && a->outpostPlayed == b->outpostPlayed);
+  assert(a->playedCardCount == b->playedCardCount);
+  assert(memcmp(a->playedCards, b->playedCards, sizeof(int) * a->playedCardCount) == 0);
+  for (p = 0; p < a->numPlayers; p++) {
+    assert(a->handCount[p] == b->handCount[p]);
+    assert(a->deckCount[p] == b->deckCount[p]);
+    assert(a->discardCount[p] == b->discardCount[p]);
+    assert(memcmp(a->hand[p], b->hand[p], sizeof(int) * a->handCount[p]) == 0);
+    assert(memcmp(a->deck[p], b->deck[p], sizeof(int) * a->deckCount[p]) == 0);
+    assert(memcmp(a->discard[p], b->discard[p], sizeof(int) * a->discardCount[p]) == 0);
+  }
+  assert(memcmp(a->pileCardCount, b->pileCardCount, sizeof(a->pileCardCount)) == 0);
+  assert(memcmp(a->fullCardCount, b->fullCardCount, sizeof(a->fullCardCount)) == 0);
+}
+
+void assertSamePosition(RngPosition *a, RngPosition *b) {
+  assert(a->stream == b->stream && a->seed == b->seed);
+  assert(memcmp(a->xoshiro, b->xoshiro, sizeof(a->xoshiro)) == 0);
+}
+
+int randomPlay(struct gameState *state) {
+  if (numHandCards(state) < 1)
+    return -1;
+  return playCard(floor(Random() * numHandCards(state)), floor(Random() * 5),
+		  floor(Random() * (treasure_map + 1)), floor(Random() * 2), state);
+}
+
+int randomBuy(struct gameState *state) {
+  int card = floor(Random() * (treasure_map + 1));
+
+  return buyCard(card, state) == 0 ? card : -1;
+}
+
+int randomGain(struct gameState *state) {
+  int card = floor(Random() * (treasure_map + 1));
+
+  return gainCard(card, state, floor(Random() * 3), whoseTurn(state));
+}
+
+void randomMove(struct gameState *state) {
+  int r = floor(Random() * 3);
+
+  if (r == 0 && numHandCards(state) > 0)
+    randomPlay(state);
+  else if (r == 1)
+    randomBuy(state);
+  else
+    endTurn(state);
+}
+
+void randomTurn(struct gameState *state) {
+  randomGain(state);
+  randomPlay(state);
+  randomBuy(state);
+}
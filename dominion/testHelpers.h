@@ -0,0 +1,36 @@
+#ifndef _TEST_HELPERS_H
+#define _TEST_HELPERS_H
+
+#include "dominion.h"
+#include "rngs.h"
+
+/* Fixture shared by the test drivers.  The random moves draw their
+   choices from the current stream of the global random numbers */
+
+void assertSameLive(struct gameState *a, struct gameState *b);
+/* Assert that a and b agree on everything but the dead slots past the
+   end of each pile */
+
+void assertSamePosition(RngPosition *a, RngPosition *b);
+/* Assert that two saved stream positions are the same, whichever
+   generator they were taken from */
+
+int randomPlay(struct gameState *state);
+/* playCard a random card of the current hand with random choices.
+   Returns what playCard does, -1 for an empty hand */
+
+int randomBuy(struct gameState *state);
+/* buyCard a random card.  Returns the card bought, -1 if the buy failed */
+
+int randomGain(struct gameState *state);
+/* gainCard a random card to a random pile of the player to act.
+   Returns what gainCard does */
+
+void randomMove(struct gameState *state);
+/* randomPlay, randomBuy or endTurn, one chance in three each */
+
+void randomTurn(struct gameState *state);
+/* randomGain, randomPlay and randomBuy in a row, which empties supply
+   piles fast; the turn does not end */
+
+#endif
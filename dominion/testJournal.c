@@ -0,0 +1,106 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+#define DEPTH 4
+
+//undo must bring back every byte the engine wrote
+void assertUndone(struct gameState *saved, RngPosition *savedPosition,
+		  struct gameState *state) {
+  RngPosition position;
+
+  GetPositionCtx(NULL, &position);
+  assertSamePosition(&position, savedPosition);
+  state->dirtyPiles = saved->dirtyPiles;
+  assert(memcmp(saved, state, sizeof(struct gameState)) == 0);
+}
+
+int main () {
+
+  int n, move, d, supply, mark[DEPTH];
+  RngPosition position[DEPTH];
+  struct moveJournal *journal;
+  struct gameState G, saved[DEPTH];
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, ambassador, cutpurse};
+
+  printf ("Testing moveJournal.\n");
+
+  journal = newJournal();
+  assert(journal != NULL);
+
+  //ambassador returns a copper to the supply and the other two players
+  //gain one each; undo puts the supply back with the piles.  The handler
+  //counts hand positions equal to the card, so copper (4) passes its copy
+  //check with five cards in hand
+  memset(&G, 0, sizeof(struct gameState));
+  assert(initializeGame(3, k, 1, &G) == 0);
+  setPileCard(0, ambassador, hand_pile, 0, &G);
+  setPileCard(1, copper, hand_pile, 0, &G);
+  supply = supplyCount(copper, &G);
+  G.journal = journal;
+  memcpy(&saved[0], &G, sizeof(struct gameState));
+  GetPositionCtx(NULL, &position[0]);
+  mark[0] = markJournal(&G);
+  assert(playCard(0, 1, 1, 0, &G) == 0);
+  assert(supplyCount(copper, &G) == supply + 1 - 2);
+  assert(undoJournal(mark[0], &G) == 0);
+  assertUndone(&saved[0], &position[0], &G);
+  assert(checkGameState(&G) == 0);
+  clearJournal(journal);
+
+  printf ("RANDOM TESTS.\n");
+
+  for (n = 0; n < 20; n++) {
+    //the engine and the moves share stream 1 so undo has to rewind both
+    memset(&G, 0, sizeof(struct gameState));
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    assert(G.journal == NULL && markJournal(&G) == -1);
+    G.journal = journal;
+    clearJournal(journal);
+
+    for (move = 0; move < 100 && !isGameOver(&G); move++) {
+      //nested marks, unwound innermost first
+      for (d = 0; d < DEPTH; d++) {
+	memcpy(&saved[d], &G, sizeof(struct gameState));
+	GetPositionCtx(NULL, &position[d]);
+	mark[d] = markJournal(&G);
+	assert(mark[d] == d);
+	randomMove(&G);
+	randomMove(&G);
+	assert(checkGameState(&G) == 0);
+      }
+      for (d = DEPTH - 1; d >= 0; d--) {
+	assert(undoJournal(mark[d], &G) == 0);
+	assertUndone(&saved[d], &position[d], &G);
+	assert(checkGameState(&G) == 0);
+      }
+
+      //a mark stays usable after undo, later ones do not
+      assert(undoJournal(mark[1], &G) == -1);
+      randomMove(&G);
+      assert(undoJournal(mark[0], &G) == 0);
+      assertUndone(&saved[0], &position[0], &G);
+
+      //keep one move and start over from there
+      clearJournal(journal);
+      randomMove(&G);
+    }
+  }
+
+  freeJournal(journal);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+#define CARDS 5
+#define ORDERS 120 /* 5! */
+#define TRIALS 24000
+
+//index 0..ORDERS-1 of the order of the first CARDS cards of a hand
+int orderIndex(int *cards) {
+  int i, j, smaller, index = 0;
+
+  for (i = 0; i < CARDS; i++) {
+    smaller = 0;
+    for (j = i + 1; j < CARDS; j++)
+      if (cards[j] < cards[i])
+	smaller++;
+    index = index * (CARDS - i) + smaller;
+  }
+  return index;
+}
+
+int main () {
+
+  int i, n, counts[ORDERS];
+  double chi2 = 0, expected = (double) TRIALS / ORDERS;
+  struct gameState G;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, tribute};
+  int deck[CARDS] = {curse, estate, copper, silver, gold};
+
+#ifdef LAZY_SHUFFLE
+  printf ("Testing lazy shuffle.\n");
+#else
+  printf ("Testing shuffle.\n");
+#endif
+
+  assert(initializeGame(2, k, 3, &G) == 0);
+
+  //every order of a shuffled deck is dealt equally often
+  memset(counts, 0, sizeof(counts));
+  for (n = 0; n < TRIALS; n++) {
+    setPileCount(0, hand_pile, 0, &G);
+    setPileCount(0, deck_pile, 0, &G);
+    for (i = 0; i < CARDS; i++)
+      pushCard(deck[i], deck_pile, 0, &G);
+    assert(G.deckKnown[0] == CARDS);
+    assert(shuffle(0, &G) == 0);
+    assert(G.deckKnown[0] == 0);
+    for (i = 0; i < CARDS; i++)
+      assert(drawCard(0, &G) == 0);
+    assert(G.deckCount[0] == 0 && G.handCount[0] == CARDS);
+    counts[orderIndex(G.hand[0])]++;
+  }
+  for (i = 0; i < ORDERS; i++)
+    chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+  //119 degrees of freedom: mean 119, standard deviation about 15
+  if (NOISY_TEST)
+    printf ("chi-square over %d orders: %.1f\n", ORDERS, chi2);
+  assert(chi2 < 200);
+  assert(checkGameState(&G) == 0);
+
+  //cards put on top after a shuffle come off first, in order
+  for (i = 0; i < CARDS; i++)
+    pushCard(deck[i], deck_pile, 0, &G);
+  shuffle(0, &G);
+  gainCard(gold, &G, 1, 0);
+  gainCard(duchy, &G, 1, 0);
+  assert(G.deckKnown[0] == 2);
+  setPileCount(0, hand_pile, 0, &G);
+  drawCard(0, &G);
+  drawCard(0, &G);
+  assert(G.hand[0][0] == duchy && G.hand[0][1] == gold);
+  assert(checkGameState(&G) == 0);
+
+  printf ("RANDOM TESTS.\n");
+
+  //tribute reveals and discards cards off other decks
+  for (n = 0; n < 20; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    SelectStream(2);
+    PutSeed(n + 1);
+    for (i = 0; i < 300 && !isGameOver(&G); i++) {
+      if (floor(Random() * 3) == 0)
+	gainCard(tribute, &G, 2, whoseTurn(&G));
+      randomPlay(&G);
+      randomBuy(&G);
+      endTurn(&G);
+      assert(checkGameState(&G) == 0);
+    }
+  }
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
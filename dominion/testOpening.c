@@ -0,0 +1,122 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+#define SEEDS 200
+#define SWEEPS 20
+
+//fill a state with the same random bytes as a reference one
+void garbage(struct gameState *state, struct gameState *same) {
+  int i;
+
+  for (i = 0; i < sizeof(struct gameState); i++)
+    ((char*)state)[i] = floor(Random() * 256);
+  memcpy(same, state, sizeof(struct gameState));
+}
+
+int main () {
+
+  int n, seed, players, sweep;
+  long x, y;
+  clock_t start;
+  double plain, cached;
+  struct openingCache *cache;
+  struct gameState G, H;
+  RngState a, b;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+  int k2[10] = {adventurer, feast, embargo, outpost, salvager,
+		sea_hag, treasure_map, tribute, minion, ambassador};
+
+  printf ("Testing openingCache.\n");
+
+  cache = newOpeningCache();
+  assert(cache != NULL);
+  assert(initializeGameCached(NULL, 2, k, 1, NULL, &G) == -1);
+  assert(initializeGameCached(cache, 5, k, 1, NULL, &G) == -1);
+  k[1] = smithy;
+  assert(initializeGameCached(cache, 2, k, 1, NULL, &G) == -1);
+  k[1] = village;
+
+  printf ("RANDOM TESTS.\n");
+
+  SelectStream(2);
+  PutSeed(7);
+  for (n = 0; n < 3 * SEEDS; n++) {
+    //the first time fills the cache, the second copies from it
+    seed = 1 + n % SEEDS;
+    players = 2 + n / SEEDS;
+    garbage(&G, &H);
+    InitRngState(&a);
+    InitRngState(&b);
+    assert(initializeGameWithRng(players, (n & 1) ? k : k2, seed, &a, &G) == 0);
+    assert(initializeGameCached(cache, players, (n & 1) ? k : k2, seed, &b, &H) == 0);
+    H.rng = G.rng;
+    assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+    assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+
+    garbage(&G, &H);
+    InitRngState(&b);
+    assert(initializeGameCached(cache, players, (n & 1) ? k2 : k, seed, &b, &H) == 0);
+    assert(initializeGameWithRng(players, (n & 1) ? k2 : k, seed, &a, &G) == 0);
+    H.rng = G.rng;
+    assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+    assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+    assert(checkGameState(&H) == 0);
+  }
+
+  //an opening cached on one generator is never replayed on the other,
+  //whichever of the two filled the cache first
+  for (n = 0; n < 4; n++) {
+    InitRngState(&b);
+    SelectGeneratorCtx(&b, n % 2 ? RNG_XOSHIRO256 : RNG_LEHMER);
+    assert(initializeGameCached(cache, 2, k, 1000 + n / 2, &b, &H) == 0);
+    garbage(&G, &H);
+    InitRngState(&a);
+    InitRngState(&b);
+    SelectGeneratorCtx(&a, n % 2 ? RNG_LEHMER : RNG_XOSHIRO256);
+    SelectGeneratorCtx(&b, n % 2 ? RNG_LEHMER : RNG_XOSHIRO256);
+    assert(initializeGameWithRng(2, k, 1000 + n / 2, &a, &G) == 0);
+    assert(initializeGameCached(cache, 2, k, 1000 + n / 2, &b, &H) == 0);
+    H.rng = G.rng;
+    assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+    assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+  }
+
+  //on the global streams too
+  assert(initializeGameCached(cache, 3, k, 5, NULL, &H) == 0);
+  GetSeed(&y);
+  assert(initializeGame(3, k, 5, &G) == 0);
+  GetSeed(&x);
+  assert(x == y && memcmp(&G, &H, sizeof(struct gameState)) == 0);
+
+  //a sweep over a fixed seed set
+  start = clock();
+  for (sweep = 0; sweep < SWEEPS; sweep++)
+    for (seed = 1; seed <= SEEDS; seed++)
+      initializeGame(4, k, seed, &G);
+  plain = (double)(clock() - start) / CLOCKS_PER_SEC;
+  start = clock();
+  for (sweep = 0; sweep < SWEEPS; sweep++)
+    for (seed = 1; seed <= SEEDS; seed++)
+      initializeGameCached(cache, 4, k, seed, NULL, &G);
+  cached = (double)(clock() - start) / CLOCKS_PER_SEC;
+  if (NOISY_TEST)
+    printf ("%d games: %.3f s plain, %.3f s cached\n", SWEEPS * SEEDS, plain, cached);
+
+  freeOpeningCache(cache);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+int main () {
+
+  int i, seed, generator;
+  int *k;
+  RngPosition freshPosition, resetPosition;
+  struct gamePool *pool;
+  struct gameState *G[40];
+  struct gameState *fresh;
+
+  printf ("Testing gamePool.\n");
+
+  pool = newGamePool(8);
+  assert(pool != NULL);
+
+  //acquire across several blocks, every state distinct and zeroed
+  for (i = 0; i < 40; i++) {
+    G[i] = acquireGame(pool);
+    assert(G[i] != NULL);
+    assert(G[i]->numPlayers == 0 && G[i]->handCount[0] == 0);
+    if (i > 0)
+      assert(G[i] != G[i-1]);
+  }
+
+  //released states are handed out again
+  releaseGame(pool, G[5]);
+  assert(acquireGame(pool) == G[5]);
+
+  k = acquireKingdomCards(pool);
+  assert(k != NULL);
+  k[0] = adventurer; k[1] = council_room; k[2] = feast; k[3] = gardens;
+  k[4] = mine; k[5] = remodel; k[6] = smithy; k[7] = village;
+  k[8] = baron; k[9] = great_hall;
+
+  assert(resetGame(pool, G[0]) == -1);
+
+  //reset must leave the state and the random stream exactly as a fresh
+  //initializeGame does
+  fresh = acquireGame(pool);
+  for (seed = 1; seed < 20; seed++) {
+    assert(setPoolTemplate(pool, 2 + seed % 3, k, seed) == 0);
+
+    memset(fresh, 0, sizeof(struct gameState));
+    assert(initializeGame(2 + seed % 3, k, seed, fresh) == 0);
+    Random();
+    GetPositionCtx(NULL, &freshPosition);
+
+    assert(resetGame(pool, G[seed]) == 0);
+    Random();
+    GetPositionCtx(NULL, &resetPosition);
+
+    assertSameLive(fresh, G[seed]);
+    assertSamePosition(&freshPosition, &resetPosition);
+  }
+
+  //the saved position is not put back onto another generator
+  generator = GetGeneratorCtx(NULL);
+  assert(SelectGenerator(generator == RNG_LEHMER ? RNG_XOSHIRO256 : RNG_LEHMER) == 0);
+  assert(resetGame(pool, G[1]) == -1);
+  assert(setPoolTemplate(pool, 2, k, 3) == 0);
+  assert(resetGame(pool, G[1]) == 0);
+  assert(SelectGenerator(generator) == 0);
+  assert(resetGame(pool, G[1]) == -1);
+
+  //kingdomCards and newGame come from the default pool
+  k = kingdomCards(adventurer, gardens, embargo, village, minion, mine,
+		   cutpurse, sea_hag, tribute, smithy);
+  assert(k[9] == smithy);
+  fresh = newGame();
+  assert(initializeGame(2, k, 1, fresh) == 0);
+  releaseGame(NULL, fresh);
+  releaseKingdomCards(NULL, k);
+  freeGamePool(NULL);
+
+  assert(freeGamePool(pool) == 0);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
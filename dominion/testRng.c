@@ -0,0 +1,281 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "interface.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+#define TURNS 40
+#define FILL 1000
+
+//one big money turn, no random choices of its own
+void playTurn(struct gameState *state) {
+  int i;
+
+  for (i = 0; i < numHandCards(state) && state->numActions > 0; i++)
+    {
+      if (handCard(i, state) == smithy || handCard(i, state) == village)
+	playCard(i, 0, 0, 0, state);
+    }
+  buyCard(state->coins >= 8 ? province : state->coins >= 6 ? gold
+	  : state->coins >= 4 ? smithy : silver, state);
+  endTurn(state);
+}
+
+//states equal apart from which streams they draw from
+void assertSameGame(struct gameState *a, struct gameState *b) {
+  struct rngState *rng = b->rng;
+
+  b->rng = a->rng;
+  assert(memcmp(a, b, sizeof(struct gameState)) == 0);
+  b->rng = rng;
+}
+
+int main () {
+
+  int i, j, n, r, turn, mark, lanes;
+  int counts[6];
+  RngPosition position;
+  double fill[FILL];
+  long x, before;
+  int k1[NUM_K_CARDS], k2[NUM_K_CARDS];
+  RngState a, b;
+  struct gameState G, H, alone[2], interleaved[2];
+  struct moveJournal *journal;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+
+  printf ("Testing RngState.\n");
+
+  //a Lehmer context reproduces the published Park-Miller values
+  InitRngState(&a);
+  assert(SelectGeneratorCtx(&a, RNG_LEHMER) == 0);
+  SelectStreamCtx(&a, 0);
+  PutSeedCtx(&a, 1);
+  for (i = 0; i < 10000; i++)
+    RandomCtx(&a);
+  GetSeedCtx(&a, &x);
+  assert(x == 399268537);
+  SelectStreamCtx(&a, 1);
+  PlantSeedsCtx(&a, 1);
+  GetSeedCtx(&a, &x);
+  assert(x == 22925);
+  assert(GetStreamCtx(&a) == 1);
+
+  //and does not touch them
+  SelectStream(3);
+  PutSeed(77);
+  InitRngState(&b);
+  SelectStreamCtx(&b, 3);
+  PutSeedCtx(&b, 77);
+  for (i = 0; i < 100; i++)
+    assert(RandomCtx(&b) == Random());
+  GetPositionCtx(NULL, &position);
+  x = Random() * MAX_DECK;
+  SetPositionCtx(NULL, &position);
+  RandomCtx(&b);
+  assert((long) (Random() * MAX_DECK) == x && GetStream() == 3);
+
+  //skipping k steps lands where k calls to Random() do
+  for (n = 0; n < 2000; n += 1 + n / 4) {
+    SelectStreamCtx(&a, 5);
+    PutSeedCtx(&a, n + 3);
+    memcpy(&b, &a, sizeof(RngState));
+    for (i = 0; i < n; i++)
+      RandomCtx(&a);
+    SkipAhead(&b, n);
+    GetSeedCtx(&a, &x);
+    GetSeedCtx(&b, &before);
+    assert(x == before);
+    SkipAhead(&b, -n);
+    GetSeedCtx(&b, &x);
+    assert(x == n + 3);
+  }
+  //streams are planted 8,367,782 steps apart
+  PlantSeedsCtx(&a, 42);
+  for (i = 0; i < 10; i++) {
+    SelectStreamCtx(&a, i);
+    SkipAhead(&a, 8367782);
+    GetSeedCtx(&a, &x);
+    SelectStreamCtx(&a, i + 1);
+    GetSeedCtx(&a, &before);
+    assert(x == before);
+  }
+
+  //bulk draws match the scalar sequence and leave the streams alike
+  InitRngState(&a);
+  InitRngState(&b);
+  SelectStreamCtx(&a, 2);
+  SelectStreamCtx(&b, 2);
+  RandomFill(&a, fill, FILL);
+  for (i = 0; i < FILL; i++)
+    assert(fill[i] == RandomCtx(&b));
+  assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+  for (lanes = 1; lanes <= 8; lanes *= 2) {
+    RandomFillStreams(&a, 3, lanes, fill, FILL / lanes);
+    for (j = 0; j < lanes; j++) {
+      SelectStreamCtx(&b, 3 + j);
+      for (i = 0; i < FILL / lanes; i++)
+	assert(fill[i * lanes + j] == RandomCtx(&b));
+    }
+    SelectStreamCtx(&b, 2);
+    assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+  }
+  //as on first use of SelectStream, unplanted streams get planted
+  InitRngState(&a);
+  InitRngState(&b);
+  RandomFillStreams(&a, 0, 4, fill, 10);
+  SelectStreamCtx(&b, 1);
+  SelectStreamCtx(&b, 0);
+  for (i = 0; i < 10; i++)
+    assert(fill[4 * i] == RandomCtx(&b));
+
+  //integer draws: the legacy mapping, and an unbiased one in range
+  InitRngState(&a);
+  InitRngState(&b);
+  for (n = 1; n < 3000; n += 1 + n / 2) {
+    assert(RandomIntLegacy(&a, n) == (int) floor(RandomCtx(&b) * n));
+    assert(RandomIntLegacy(&a, n) < n);
+    RandomCtx(&b);
+  }
+  assert(RandomInt(&a, 0) == -1 && RandomIntLegacy(&a, -1) == -1);
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < 60000; i++) {
+    r = RandomInt(&a, 6);
+    assert(r >= 0 && r < 6);
+    counts[r]++;
+  }
+  for (i = 0; i < 6; i++)
+    assert(counts[i] > 9500 && counts[i] < 10500);
+  assert(RandomInt(&a, 1) == 0);
+  assert(RandomInt(&a, 2147483646) >= 0);
+
+  selectKingdomCards(12, k1);
+  selectKingdomCardsCtx(&a, 12, k2);
+  assert(memcmp(k1, k2, sizeof(k1)) == 0);
+
+  printf ("RANDOM TESTS.\n");
+
+  for (n = 0; n < 20; n++) {
+    //each game alone on the global streams
+    for (i = 0; i < 2; i++)
+      {
+	assert(initializeGame(2 + n % 3, k, 2 * n + i + 1, &alone[i]) == 0);
+	for (turn = 0; turn < TURNS && !isGameOver(&alone[i]); turn++)
+	  playTurn(&alone[i]);
+      }
+
+    //both at once, a turn each, with the global streams in use meanwhile
+    InitRngState(&a);
+    InitRngState(&b);
+    assert(initializeGameWithRng(2 + n % 3, k, 2 * n + 1, &a, &interleaved[0]) == 0);
+    assert(initializeGameWithRng(2 + n % 3, k, 2 * n + 2, &b, &interleaved[1]) == 0);
+    assert(interleaved[0].rng == &a && interleaved[1].rng == &b);
+    PutSeed(n + 1);
+    for (turn = 0; turn < TURNS; turn++)
+      for (i = 0; i < 2; i++)
+	if (!isGameOver(&interleaved[i]))
+	  {
+	    playTurn(&interleaved[i]);
+	    Random();
+	  }
+    assertSameGame(&alone[0], &interleaved[0]);
+    assertSameGame(&alone[1], &interleaved[1]);
+  }
+
+  //undo rewinds the game's own streams
+  journal = newJournal();
+  assert(journal != NULL);
+  InitRngState(&a);
+  SelectGeneratorCtx(&a, RNG_LEHMER);
+  assert(initializeGameWithRng(2, k, 5, &a, &G) == 0);
+  G.journal = journal;
+  mark = markJournal(&G);
+  memcpy(&H, &G, sizeof(struct gameState));
+  GetSeedCtx(&a, &before);
+  for (i = 0; i < 6; i++)
+    playTurn(&G);
+  GetSeedCtx(&a, &x);
+  assert(x != before);
+  assert(undoJournal(mark, &G) == 0);
+  H.dirtyPiles = G.dirtyPiles;
+  assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+  GetSeedCtx(&a, &x);
+  assert(x == before);
+
+  //and does so on the other generator, whose state GetSeed cannot hold
+  assert(SelectGeneratorCtx(&a, RNG_XOSHIRO256) == 0);
+  assert(initializeGameWithRng(2, k, 5, &a, &G) == 0);
+  G.journal = journal;
+  clearJournal(journal);
+  mark = markJournal(&G);
+  memcpy(&H, &G, sizeof(struct gameState));
+  memcpy(&b, &a, sizeof(RngState));
+  for (i = 0; i < 6; i++)
+    playTurn(&G);
+  assert(undoJournal(mark, &G) == 0);
+  H.dirtyPiles = G.dirtyPiles;
+  assert(memcmp(&G, &H, sizeof(struct gameState)) == 0);
+  assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+  freeJournal(journal);
+
+  printf ("Testing xoshiro256**.\n");
+
+  assert(SelectGeneratorCtx(&a, 7) == -1);
+  assert(SelectGeneratorCtx(&a, RNG_XOSHIRO256) == 0);
+  assert(GetGeneratorCtx(&a) == RNG_XOSHIRO256
+	 && GetGeneratorCtx(NULL) == RNG_DEFAULT_GENERATOR);
+  InitRngState(&b);
+  SelectGeneratorCtx(&b, RNG_XOSHIRO256);
+  PutSeedCtx(&a, 9);
+  PutSeedCtx(&b, 9);
+  assert(SkipAhead(&a, 10) == -1);
+  RandomFill(&a, fill, FILL);
+  for (i = 0; i < FILL; i++) {
+    assert(fill[i] >= 0 && fill[i] < 1);
+    assert(fill[i] == RandomCtx(&b));
+  }
+  assert(memcmp(&a, &b, sizeof(RngState)) == 0);
+  //planted streams differ, and the Lehmer generator gives other values
+  SelectStreamCtx(&a, 1);
+  SelectStreamCtx(&b, 2);
+  assert(RandomCtx(&a) != RandomCtx(&b));
+  InitRngState(&b);
+  SelectGeneratorCtx(&b, RNG_LEHMER);
+  SelectStreamCtx(&a, 0);
+  PutSeedCtx(&a, 9);
+  PutSeedCtx(&b, 9);
+  assert(RandomCtx(&a) != RandomCtx(&b));
+  //positions
+  GetPositionCtx(&a, &position);
+  x = RandomCtx(&a) * MAX_DECK;
+  RandomCtx(&a);
+  SetPositionCtx(&a, &position);
+  assert((long) (RandomCtx(&a) * MAX_DECK) == x);
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < 60000; i++) {
+    r = RandomInt(&a, 6);
+    assert(r >= 0 && r < 6);
+    counts[r]++;
+  }
+  for (i = 0; i < 6; i++)
+    assert(counts[i] > 9500 && counts[i] < 10500);
+  memcpy(&b, &a, sizeof(RngState));
+  RandomFillStreams(&a, 4, 4, fill, 10);
+  for (j = 0; j < 4; j++) {
+    SelectStreamCtx(&b, 4 + j);
+    for (i = 0; i < 10; i++)
+      assert(fill[i * 4 + j] == RandomCtx(&b));
+  }
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
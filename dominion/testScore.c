@@ -0,0 +1,102 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//score by a full scan of hand, discard and deck
+int scanScore(int player, struct gameState *G) {
+  int *piles[3] = {G->hand[player], G->discard[player], G->deck[player]};
+  int counts[3] = {G->handCount[player], G->discardCount[player], G->deckCount[player]};
+  int i, pile, total = 0, gardenCards = 0, score = 0;
+
+  for (pile = 0; pile < 3; pile++)
+    for (i = 0; i < counts[pile]; i++)
+      if (VALID_CARD(piles[pile][i])) {
+	total++;
+	score += cardTable[piles[pile][i]].vp;
+	if (piles[pile][i] == gardens)
+	  gardenCards++;
+      }
+  return score + gardenCards * (total / 10);
+}
+
+int main () {
+
+  int i, n, p, card, mark;
+  int before[MAX_PLAYERS];
+  struct gameState G;
+  struct moveJournal *journal;
+
+  int k[10] = {gardens, great_hall, ambassador, remodel, salvager,
+	       smithy, village, minion, sea_hag, feast};
+
+  printf ("Testing scoreFor.\n");
+
+  //three estates to start with
+  assert(initializeGame(2, k, 1, &G) == 0);
+  assert(scoreFor(0, &G) == 3 && scoreFor(1, &G) == 3);
+  assert(G.cardTotal[0] == 10 && G.victoryPoints[0] == 3);
+
+  //cards in the deck count as much as those in hand
+  card = G.deck[0][0];
+  setPileCard(0, province, deck_pile, 0, &G);
+  assert(scoreFor(0, &G) == 3 + 6 - (card == estate));
+  assert(scoreFor(0, &G) == scanScore(0, &G));
+
+  //gardens are worth a point per ten cards, whatever the cards are
+  gainCard(gardens, &G, 0, 0);
+  assert(G.cardTotal[0] == 11 && scoreFor(0, &G) == scanScore(0, &G));
+  for (i = 0; i < 9; i++)
+    gainCard(curse, &G, 0, 0);
+  assert(G.cardTotal[0] == 20);
+  assert(scoreFor(0, &G) == scanScore(0, &G));
+
+  //trashing takes the points away
+  gainCard(duchy, &G, 2, 0);
+  n = scoreFor(0, &G);
+  discardCard(numHandCards(&G) - 1, 0, &G, 1);
+  assert(scoreFor(0, &G) == n - 3 && scoreFor(0, &G) == scanScore(0, &G));
+  assert(checkGameState(&G) == 0);
+
+  printf ("RANDOM TESTS.\n");
+
+  journal = newJournal();
+  assert(journal != NULL);
+  SelectStream(2);
+  PutSeed(3);
+  for (n = 0; n < 100; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    for (p = 0; p < G.numPlayers; p++)
+      before[p] = scoreFor(p, &G);
+    G.journal = journal;
+    clearJournal(journal);
+    mark = markJournal(&G);
+    for (i = 0; i < 300 && !isGameOver(&G); i++) {
+      randomTurn(&G);
+      for (p = 0; p < G.numPlayers; p++)
+	assert(scoreFor(p, &G) == scanScore(p, &G));
+      assert(checkGameState(&G) == 0);
+      endTurn(&G);
+    }
+
+    //undo puts the points back with the cards
+    assert(undoJournal(mark, &G) == 0);
+    for (p = 0; p < G.numPlayers; p++)
+      assert(scoreFor(p, &G) == before[p]);
+    assert(checkGameState(&G) == 0);
+    G.journal = NULL;
+  }
+  freeJournal(journal);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}
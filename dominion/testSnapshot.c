@@ -0,0 +1,133 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "testHelpers.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include "rngs.h"
+
+#define DEBUG 0
+#define NOISY_TEST 1
+
+//PILE_BIT of every pile whose live part differs between a and b
+unsigned int changedPiles(struct gameState *a, struct gameState *b) {
+  unsigned int piles = 0;
+  int p;
+
+  for (p = 0; p < a->numPlayers; p++) {
+    if (a->handCount[p] != b->handCount[p]
+	|| memcmp(a->hand[p], b->hand[p], sizeof(int) * a->handCount[p]) != 0)
+      piles |= PILE_BIT(hand_pile, p);
+    if (a->deckCount[p] != b->deckCount[p]
+	|| memcmp(a->deck[p], b->deck[p], sizeof(int) * a->deckCount[p]) != 0)
+      piles |= PILE_BIT(deck_pile, p);
+    if (a->discardCount[p] != b->discardCount[p]
+	|| memcmp(a->discard[p], b->discard[p], sizeof(int) * a->discardCount[p]) != 0)
+      piles |= PILE_BIT(discard_pile, p);
+  }
+  if (a->playedCardCount != b->playedCardCount
+      || memcmp(a->playedCards, b->playedCards, sizeof(int) * a->playedCardCount) != 0)
+    piles |= PILE_BIT(played_pile, 0);
+
+  return piles;
+}
+
+int main () {
+
+  int n, move, p, fields;
+  unsigned int piles, drawPiles;
+  struct gameSnapshot *snap;
+  struct gameState G, pre;
+
+  int k[10] = {smithy, village, great_hall, council_room, gardens,
+	       mine, remodel, baron, steward, cutpurse};
+
+  printf ("Testing gameSnapshot.\n");
+
+  snap = newSnapshot();
+  assert(snap != NULL);
+
+  printf ("RANDOM TESTS.\n");
+
+  SelectStream(2);
+  PutSeed(11);
+
+  for (n = 0; n < 20; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    SelectStream(2);
+
+    for (move = 0; move < 300 && !isGameOver(&G); move++) {
+      assert(takeSnapshot(&G, snap) == 0);
+      assert(G.dirtyPiles == 0);
+      memcpy(&pre, &G, sizeof(struct gameState));
+
+      randomMove(&G);
+
+      //every changed pile was marked dirty and is reported by the diff
+      fields = diffSnapshot(snap, &G, &piles);
+      assert((changedPiles(&pre, &G) & ~G.dirtyPiles) == 0);
+      assert(piles == changedPiles(&pre, &G));
+      assert(!!(fields & field_coins) ==
+	     (pre.coins != G.coins || pre.bonusCoins != G.bonusCoins));
+      assert(!!(fields & field_whoseTurn) == (pre.whoseTurn != G.whoseTurn));
+      assert(!!(fields & field_numBuys) == (pre.numBuys != G.numBuys));
+      assert(!!(fields & field_supplyCount) ==
+	     (memcmp(pre.supplyCount, G.supplyCount, sizeof(G.supplyCount)) != 0));
+      assert(checkGameState(&G) == 0);
+
+      //undo the move, then make it stick half of the time
+      assert(restoreSnapshot(snap, &G) == 0);
+      assertSameLive(&pre, &G);
+      assert(diffSnapshot(snap, &G, &piles) == 0 && piles == 0);
+      if (Random() < 0.5)
+	randomMove(&G);
+    }
+  }
+
+  //drawCard only touches the drawer's hand and deck, and the discard
+  //pile it shuffles back in when the deck runs out
+  for (n = 0; n < 20; n++) {
+    assert(initializeGame(2 + n % 3, k, n + 1, &G) == 0);
+    SelectStream(2);
+
+    for (move = 0; move < 200; move++) {
+      p = floor(Random() * G.numPlayers);
+      drawPiles = PILE_BIT(hand_pile, p) | PILE_BIT(deck_pile, p);
+      if (G.deckCount[p] <= 0)
+	drawPiles |= PILE_BIT(discard_pile, p);
+      assert(takeSnapshot(&G, snap) == 0);
+      memcpy(&pre, &G, sizeof(struct gameState));
+      if (drawCard(p, &G) < 0) {
+	endTurn(&G);
+	continue;
+      }
+
+      fields = diffSnapshot(snap, &G, &piles);
+      assert((fields & ~(field_deckKnown | field_shuffles | field_coins)) == 0);
+      assert(!!(fields & field_coins) == (pre.coins != G.coins));
+      assert((G.dirtyPiles & ~drawPiles) == 0);
+      assert((piles & ~drawPiles) == 0);
+      assert(piles & PILE_BIT(hand_pile, p));
+
+      //restoring every pile is the same as restoring the dirty ones
+      assert(restoreSnapshot(snap, &G) == 0);
+      assertSameLive(&pre, &G);
+      G.dirtyPiles = (1u << PILE_SLOTS) - 1;
+      assert(diffSnapshot(snap, &G, &piles) == 0 && piles == 0);
+      assert(checkGameState(&G) == 0);
+
+      //keep the card, and now and then end the turn to refill the discard
+      drawCard(p, &G);
+      if (Random() < 0.2)
+	endTurn(&G);
+    }
+  }
+
+  freeSnapshot(snap);
+
+  printf ("ALL TESTS OK\n");
+
+  return 0;
+}